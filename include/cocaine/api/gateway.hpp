@@ -40,6 +40,7 @@ struct gateway_t {
     }
 
     typedef result_of<io::locator::resolve>::type metadata_t;
+    typedef io::locator::synchronize::load_tuple_type load_t;
 
     virtual
     metadata_t
@@ -53,6 +54,14 @@ struct gateway_t {
     void
     cleanup(const std::string& uuid, const std::string& name) = 0;
 
+    // Periodically refreshed load metrics of the services published by the remote node. Gateways
+    // which don't balance the load are free to ignore them.
+    virtual
+    void
+    update(const std::string& /* uuid */, const std::map<std::string, load_t>& /* load */) {
+        // Empty.
+    }
+
 protected:
     gateway_t(context_t&, const std::string& /* name */, const dynamic_t& /* args */) {
         // Empty.
@@ -26,6 +26,8 @@
 
 #include <thread>
 
+#include <boost/optional.hpp>
+
 namespace cocaine { namespace api {
 
 struct event_t;
@@ -79,6 +81,10 @@ public:
     dynamic_t
     info() const;
 
+    // Queue depth and the number of active slaves, unless the engine is stopped.
+    boost::optional<std::tuple<uint64_t, uint64_t>>
+    load() const;
+
     // Scheduling
 
     std::shared_ptr<api::stream_t>
@@ -86,6 +92,9 @@ public:
 
     std::shared_ptr<api::stream_t>
     enqueue(const api::event_t& event, const std::shared_ptr<api::stream_t>& upstream, const std::string& tag);
+
+    std::vector<std::shared_ptr<api::stream_t>>
+    enqueue(const std::vector<api::event_t>& events, const std::vector<std::shared_ptr<api::stream_t>>& upstreams);
 };
 
 } // namespace cocaine
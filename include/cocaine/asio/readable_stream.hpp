@@ -92,6 +92,12 @@ struct readable_stream {
         return m_ring.size();
     }
 
+    // Number of bytes received but not yet consumed.
+    size_t
+    pending() const {
+        return m_rd_offset - m_rx_offset;
+    }
+
 private:
     void
     on_event(ev::io& /* io */, int /* revents */) {
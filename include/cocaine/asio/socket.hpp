@@ -79,6 +79,27 @@ struct socket {
         ::fcntl(m_fd, F_SETFL, O_NONBLOCK);
     }
 
+    // Starts a non-blocking connection. The socket becomes writable as soon as the connection is
+    // either established or failed, then error() tells which one it is.
+    socket(endpoint_type endpoint, std::error_code& ec) {
+        typename endpoint_type::protocol_type protocol = endpoint.protocol();
+
+        m_fd = ::socket(protocol.family(), protocol.type(), protocol.protocol());
+
+        if(m_fd == -1) {
+            throw std::system_error(errno, std::system_category(), "unable to create a socket");
+        }
+
+        medium_type::configure(m_fd);
+
+        ::fcntl(m_fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(m_fd, F_SETFL, O_NONBLOCK);
+
+        if(::connect(m_fd, endpoint.data(), endpoint.size()) != 0 && errno != EINPROGRESS) {
+            ec = std::error_code(errno, std::system_category());
+        }
+    }
+
     explicit
     socket(int fd):
         m_fd(fd)
@@ -132,6 +153,19 @@ public:
         return m_fd;
     }
 
+    // Pending socket error, e.g. the outcome of a non-blocking connection.
+    std::error_code
+    error() const {
+        int code = 0;
+        socklen_t size = sizeof(code);
+
+        if(::getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &code, &size) != 0) {
+            code = errno;
+        }
+
+        return std::error_code(code, std::system_category());
+    }
+
     endpoint_type
     local_endpoint() const {
         endpoint_type endpoint;
@@ -72,6 +72,12 @@ struct writable_stream {
         return m_ring.size();
     }
 
+    // Number of bytes enqueued but not yet sent.
+    size_t
+    pending() const {
+        return m_wr_offset - m_tx_offset;
+    }
+
     struct deferred_wakeup_action {
         void
         operator()() const { }
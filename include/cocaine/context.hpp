@@ -26,7 +26,11 @@
 #include "cocaine/locked_ptr.hpp"
 #include "cocaine/repository.hpp"
 
+#include "cocaine/detail/snapshot.hpp"
+
+#include <mutex>
 #include <queue>
+#include <random>
 
 #include <boost/optional.hpp>
 
@@ -39,14 +43,28 @@ struct defaults {
     static const float idle_timeout;
     static const float startup_timeout;
     static const float termination_timeout;
+    static const float report_interval;
+    static const float steal_threshold;
     static const unsigned long pool_limit;
     static const unsigned long queue_limit;
+    static const unsigned long worker_queue_limit;
     static const unsigned long concurrency;
     static const unsigned long crashlog_limit;
+    static const unsigned long shared_memory_threshold;
+    static const unsigned long cache_size;
+    static const unsigned long cache_body_limit;
+    static const float autoscaling_interval;
+    static const float autoscaling_window;
+    static const float autoscaling_utilization;
+    static const float autoscaling_cooldown;
+    static const float shedding_target;
+    static const float shedding_interval;
+    static const float concurrency_tolerance;
 
     // Default I/O policy.
     static const float control_timeout;
     static const unsigned decoder_granularity;
+    static const float migration_interval;
 
     // Default paths.
     static const char plugins_path[];
@@ -91,6 +109,29 @@ struct config_t {
         boost::optional<component_t> gateway;
     } network;
 
+    struct {
+        // Number of execution units, zero means twice the number of hardware threads.
+        unsigned long units;
+
+        // NOTE: CPU sets are specified either as CPU lists like '0-3,8', or as NUMA nodes like
+        // 'node:1'. Execution units either share the whole set, or each one of them is pinned to
+        // a single CPU from it in a round-robin fashion.
+        std::string affinity;
+        bool pinned;
+
+        // CPU sets for the service actor threads, keyed by the published service name, i.e. the
+        // service configuration key, the app name or 'locator'.
+        std::map<std::string, std::string> services;
+
+        // NOTE: Connection placement policy across the execution units, either 'least-connections',
+        // 'least-busy', 'power-of-two' or 'hash'.
+        std::string placement;
+
+        // How often idle connections are moved away from the overloaded execution units, in seconds,
+        // zero disables the migration.
+        float migration_interval;
+    } execution;
+
     typedef std::map<std::string, component_t> component_map_t;
 
     component_map_t loggers;
@@ -136,9 +177,22 @@ class context_t {
     // and stop other services during their lifetime.
     synchronized<service_list_t> m_services;
 
+    struct service_index_t;
+
+    // Immutable index of the published services and their metadata, republished on every change
+    // under the services lock, so that lookups and locator dumps never have to take it.
+    snapshot<service_index_t> m_index;
+
     // A pool of execution units - threads responsible for doing all the service invocations.
     std::vector<std::unique_ptr<execution_unit_t>> m_pool;
 
+    // Guards the pool against the connection migration while it's being grown or destroyed.
+    std::mutex m_pool_mutex;
+
+    // Random choices for the connection placement.
+    std::minstd_rand m_random;
+    std::mutex m_random_mutex;
+
     struct synchronization_t;
 
     // Synchronization object is responsible for tracking remote clients and sending them service
@@ -182,9 +236,20 @@ public:
     void
     attach(const std::shared_ptr<io::socket<io::tcp>>& ptr, const std::shared_ptr<io::dispatch_t>& dispatch);
 
+    // Moves idle connections from the given execution unit to the least loaded one, if the load is
+    // uneven enough. Called by the execution units from their own threads.
+    void
+    rebalance(execution_unit_t& unit);
+
 private:
     void
     bootstrap();
+
+    void
+    publish(const service_list_t& services);
+
+    auto
+    reports() -> std::map<std::string, std::map<std::string, std::tuple<size_t, size_t>>>;
 };
 
 template<class Category, typename... Args>
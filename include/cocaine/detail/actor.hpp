@@ -63,6 +63,11 @@ public:
     void
     run(std::vector<io::tcp::endpoint> endpoints);
 
+    // Binds the actor thread to the CPU set configured for the service published under the given
+    // name, if there's any.
+    void
+    pin(const std::string& name);
+
     void
     terminate();
 
@@ -75,6 +80,11 @@ public:
     metadata_t
     metadata() const;
 
+    auto
+    prototype() const -> const io::dispatch_t& {
+        return *m_prototype;
+    }
+
 private:
     void
     on_connect(const std::shared_ptr<io::socket<io::tcp>>& socket);
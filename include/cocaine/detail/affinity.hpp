@@ -0,0 +1,68 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_AFFINITY_HPP
+#define COCAINE_AFFINITY_HPP
+
+#include "cocaine/common.hpp"
+
+#include <system_error>
+
+#include <pthread.h>
+
+namespace cocaine {
+
+// A set of CPUs to bind threads to. The specification is either a CPU list in the kernel format,
+// like '0-3,8,10-11', or a NUMA node reference, like 'node:1', which expands to all the CPUs that
+// belong to that node. An empty specification means no binding at all.
+
+class affinity_t {
+    std::vector<unsigned> m_cpus;
+
+public:
+    affinity_t() { }
+
+    explicit
+    affinity_t(const std::string& spec);
+
+    // Narrows the set down to a single CPU, picked round-robin by the given index.
+    affinity_t
+    select(size_t index) const;
+
+    // Binds the thread to the CPU set, unless the set is empty.
+    std::error_code
+    apply(pthread_t thread) const;
+
+public:
+    bool
+    empty() const {
+        return m_cpus.empty();
+    }
+
+    const std::vector<unsigned>&
+    cpus() const {
+        return m_cpus;
+    }
+};
+
+} // namespace cocaine
+
+#endif
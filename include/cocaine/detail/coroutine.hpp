@@ -0,0 +1,106 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_COROUTINE_HPP
+#define COCAINE_COROUTINE_HPP
+
+#include "cocaine/common.hpp"
+
+#include <functional>
+
+#include <ucontext.h>
+
+namespace cocaine {
+
+// Stackful coroutine bound to a reactor. It is always resumed on the reactor thread, so the body
+// can freely touch the reactor-owned state and may suspend itself while waiting for something to
+// happen, without blocking the reactor.
+//
+// NOTE: The stack is guarded by an inaccessible page, so an overflow crashes right away instead of
+// corrupting the memory. Context switches are done with swapcontext(), which also saves and restores
+// the signal mask, i.e. every switch costs a sigprocmask() system call.
+//
+// NOTE: A coroutine which is destroyed while suspended is not unwound, so the objects on its stack
+// are never destroyed and whatever they own is leaked. The await helpers always resume it, possibly
+// with an error, so it only happens if the reactor is destroyed with the resumption still pending.
+
+class coroutine_t:
+    public std::enable_shared_from_this<coroutine_t>
+{
+    COCAINE_DECLARE_NONCOPYABLE(coroutine_t)
+
+    io::reactor_t& m_reactor;
+
+    const std::function<void()> m_body;
+
+    // The stack memory, including the guard page at its bottom.
+    void* m_stack;
+    size_t m_stack_size;
+
+    ucontext_t m_caller;
+    ucontext_t m_callee;
+
+    bool m_done;
+
+public:
+    static const size_t default_stack_size;
+
+    coroutine_t(io::reactor_t& reactor, const std::function<void()>& body, size_t stack_size = default_stack_size);
+   ~coroutine_t();
+
+    // Runs the coroutine until it either suspends itself or finishes. Must be called on the reactor
+    // thread, which is what schedule() does.
+    void
+    resume();
+
+    // Posts the coroutine resumption to the reactor. Safe to call from any thread.
+    void
+    schedule();
+
+    // Returns control to whoever has resumed the coroutine. Must be called from within the body.
+    void
+    suspend();
+
+public:
+    io::reactor_t&
+    reactor() {
+        return m_reactor;
+    }
+
+    bool
+    done() const {
+        return m_done;
+    }
+
+    // The coroutine running on this thread, if any.
+    static
+    coroutine_t*
+    current();
+
+private:
+    static
+    void
+    trampoline(unsigned int hi, unsigned int lo);
+};
+
+} // namespace cocaine
+
+#endif
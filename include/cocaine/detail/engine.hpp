@@ -24,41 +24,106 @@
 #include "cocaine/common.hpp"
 #include "cocaine/locked_ptr.hpp"
 
+#include "cocaine/detail/affinity.hpp"
+#include "cocaine/detail/atomic.hpp"
+
 #include "cocaine/rpc/session.hpp"
 
 #define BOOST_BIND_NO_PLACEHOLDERS
 #include <boost/thread/thread.hpp>
 
+namespace ev {
+    struct timer;
+}
+
 namespace cocaine {
 
 class execution_unit_t {
+    context_t& m_context;
+
     const std::unique_ptr<logging::log_t> m_log;
 
     // Connections
 
-    std::map<int, std::shared_ptr<session_t>> m_sessions;
+    struct slot_t {
+        slot_t(): generation(0) { }
+
+        std::shared_ptr<session_t> session;
+
+        // NOTE: Bumped every time the slot is vacated, so that the callbacks which were queued up
+        // for the previous connection on the same fd could be told apart and ignored.
+        uint64_t generation;
+    };
+
+    // Sessions indexed by their file descriptors, as those are small and densely allocated.
+    std::vector<slot_t> m_sessions;
+
+    // Statistics
+
+    std::atomic<size_t> m_connections;
+    std::atomic<uint64_t> m_messages;
+
+    // Time spent handling the messages in microseconds, in total and over the last sampling interval.
+    std::atomic<uint64_t> m_busy_time;
+    std::atomic<uint64_t> m_recent_busy_time;
+
+    uint64_t m_busy_mark;
 
     // I/O Reactor
 
     std::unique_ptr<io::reactor_t> m_reactor;
+
+    std::unique_ptr<ev::timer> m_sampling_timer;
+    std::unique_ptr<ev::timer> m_migration_timer;
+
     std::unique_ptr<boost::thread> m_chamber;
 
 public:
-    execution_unit_t(context_t& context, const std::string& name);
+    execution_unit_t(context_t& context, const std::string& name, const affinity_t& affinity);
    ~execution_unit_t();
 
     void
     attach(const std::shared_ptr<io::socket<io::tcp>>& ptr, const std::shared_ptr<io::dispatch_t>& dispatch);
 
+    // Moves up to the given number of idle connections to the target unit. Must be called from
+    // this unit's thread.
+    size_t
+    migrate(execution_unit_t& target, size_t count);
+
+public:
+    size_t
+    connections() const {
+        return m_connections.load(std::memory_order_relaxed);
+    }
+
+    uint64_t
+    messages() const {
+        return m_messages.load(std::memory_order_relaxed);
+    }
+
+    uint64_t
+    busy_time() const {
+        return m_recent_busy_time.load(std::memory_order_relaxed);
+    }
+
 private:
     void
     on_connect(const std::shared_ptr<io::socket<io::tcp>>& ptr, const std::shared_ptr<io::dispatch_t>& dispatch);
 
     void
-    on_message(int fd, const io::message_t& message);
+    on_message(int fd, uint64_t generation, const io::message_t& message);
+
+    void
+    on_failure(int fd, uint64_t generation, const std::error_code& error);
+
+    void
+    remove(int fd);
+
+    void
+    on_sample(ev::timer&, int);
 
     void
-    on_failure(int fd, const std::error_code& error);
+    on_migrate(ev::timer&, int);
 };
 
 } // namespace cocaine
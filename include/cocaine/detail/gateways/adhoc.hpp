@@ -23,6 +23,8 @@
 
 #include "cocaine/api/gateway.hpp"
 
+#include <chrono>
+#include <mutex>
 #include <random>
 
 namespace cocaine { namespace gateway {
@@ -38,9 +40,24 @@ class adhoc_t:
     mutable std::minstd_rand0 m_random_generator;
 #endif
 
+#if defined(__clang__) || defined(HAVE_GCC47)
+    typedef std::chrono::steady_clock clock_type;
+#else
+    typedef std::chrono::monotonic_clock clock_type;
+#endif
+
+    // NOTE: Either picks a random node, or the less loaded one of two random nodes, based on the
+    // load metrics which are not older than the staleness limit.
+    bool m_power_of_two;
+    clock_type::duration m_staleness;
+
     struct remote_service_t {
         std::string uuid;
         metadata_t  meta;
+
+        // Last known load metrics and when they were received.
+        load_t load;
+        clock_type::time_point updated;
     };
 
     typedef std::multimap<
@@ -50,6 +67,10 @@ class adhoc_t:
 
     remote_service_map_t m_remote_services;
 
+    // NOTE: The load metrics are updated on the locator thread, while the services are resolved on
+    // the client threads, so the service map and the random generator are guarded.
+    mutable std::mutex m_mutex;
+
 public:
     adhoc_t(context_t& context, const std::string& name, const dynamic_t& args);
 
@@ -67,6 +88,14 @@ public:
     virtual
     void
     cleanup(const std::string& uuid, const std::string& name);
+
+    virtual
+    void
+    update(const std::string& uuid, const std::map<std::string, load_t>& load);
+
+private:
+    remote_service_map_t::const_iterator
+    select(remote_service_map_t::const_iterator lhs, remote_service_map_t::const_iterator rhs) const;
 };
 
 }} // namespace cocaine::gateway
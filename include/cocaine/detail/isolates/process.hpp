@@ -23,6 +23,8 @@
 
 #include "cocaine/api/isolate.hpp"
 
+#include <mutex>
+
 #include <boost/filesystem/path.hpp>
 
 #ifdef COCAINE_ALLOW_CGROUPS
@@ -45,10 +47,19 @@ class process_t:
     const boost::filesystem::path m_working_directory;
 
 #ifdef COCAINE_ALLOW_CGROUPS
-    // Control group handle.
+    // Control group handle, if there are any controllers configured.
     cgroup* m_cgroup;
 #endif
 
+    // Cached environment block for the spawned processes.
+    api::string_map_t m_environment;
+
+    std::vector<std::string> m_envp_storage;
+    std::vector<char*> m_envp;
+
+    // Spawning interlocking.
+    std::mutex m_mutex;
+
 public:
     process_t(context_t& context, const std::string& name, const dynamic_t& args);
 
@@ -62,6 +73,28 @@ public:
     virtual
     std::unique_ptr<api::handle_t>
     spawn(const std::string& path, const api::string_map_t& args, const api::string_map_t& environment);
+
+    // Descriptor number under which an extra descriptor is passed to the spawned process.
+    static const int inherited_descriptor = 3;
+
+    // Same as above, but also passes the given descriptor to the process as the inherited one. The
+    // original descriptor is expected to be close-on-exec, so that it doesn't leak into the other
+    // processes spawned at the same time.
+    std::unique_ptr<api::handle_t>
+    spawn(const std::string& path, const api::string_map_t& args, const api::string_map_t& environment,
+          int descriptor);
+
+private:
+    void
+    prepare(const api::string_map_t& environment);
+
+    // Starts the process via posix_spawn(), where it's available.
+    pid_t
+    spawn_posix(const std::string& path, std::vector<char*>& argv, int output, int descriptor);
+
+    // Starts the process via fork() and execve(), attaching it to the control group in between.
+    pid_t
+    spawn_forked(const std::string& path, std::vector<char*>& argv, int output, int descriptor);
 };
 
 }} // namespace cocaine::isolate
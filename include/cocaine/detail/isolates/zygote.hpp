@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_ZYGOTE_ISOLATE_HPP
+#define COCAINE_ZYGOTE_ISOLATE_HPP
+
+#include "cocaine/api/isolate.hpp"
+
+#include <mutex>
+
+namespace cocaine { namespace isolate {
+
+class process_t;
+
+// The zygote isolate launches the app executable once, in the fork-server mode, passing it the
+// control socket descriptor via the '--zygote' argument. The zygote is expected to load the app,
+// and then fork a warm worker on every request read from the control socket. A request is the
+// worker's argument map packed with msgpack, and the response is the worker's pid, with the read
+// end of its output pipe attached as the SCM_RIGHTS ancillary data. The zygote itself is spawned
+// via the process isolate, so that it inherits the working directory and the cgroup settings. It's
+// relaunched whenever the environment changes, as the workers inherit it from the zygote.
+
+class zygote_t:
+    public api::isolate_t
+{
+    context_t& m_context;
+
+    const std::unique_ptr<logging::log_t> m_log;
+
+    // Control socket timeout, in seconds.
+    const float m_timeout;
+
+    // Isolate used to launch the zygote itself.
+    std::unique_ptr<process_t> m_process;
+
+    // Zygote process handle and its control socket.
+    std::unique_ptr<api::handle_t> m_zygote;
+
+    int m_control;
+
+    // Environment the zygote has been launched with.
+    api::string_map_t m_environment;
+
+    // Logs the zygote output as it comes, so that the zygote never blocks on a full pipe.
+    struct drainer_t;
+
+    std::unique_ptr<drainer_t> m_drainer;
+
+    // Spawning interlocking.
+    std::mutex m_mutex;
+
+public:
+    zygote_t(context_t& context, const std::string& name, const dynamic_t& args);
+
+    virtual
+   ~zygote_t();
+
+    virtual
+    void
+    spool();
+
+    virtual
+    std::unique_ptr<api::handle_t>
+    spawn(const std::string& path, const api::string_map_t& args, const api::string_map_t& environment);
+
+private:
+    void
+    launch(const std::string& path, const api::string_map_t& args, const api::string_map_t& environment);
+
+    std::unique_ptr<api::handle_t>
+    fork(const api::string_map_t& args);
+
+    void
+    reset();
+};
+
+}} // namespace cocaine::isolate
+
+#endif
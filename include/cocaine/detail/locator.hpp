@@ -37,6 +37,7 @@ namespace ev {
 namespace cocaine {
 
 class session_t;
+class worker_pool_t;
 
 class locator_t:
     public implements<io::locator_tag>
@@ -60,6 +61,13 @@ class locator_t:
     // disambiguate between different runtime instances on the same host.
     std::map<remote_id_t, std::shared_ptr<session_t>> m_remotes;
 
+    class connector_t;
+
+    // Remote nodes which are still being resolved or connected to. Name resolution is blocking, so
+    // it's done on separate threads, in order not to stall the locator reactor.
+    std::map<remote_id_t, std::shared_ptr<connector_t>> m_connecting;
+    std::unique_ptr<worker_pool_t> m_resolver;
+
     // Remote gateway.
     std::unique_ptr<api::gateway_t> m_gateway;
 
@@ -100,6 +108,9 @@ private:
     void
     on_announce_timer(ev::timer&, int);
 
+    void
+    on_connect(const remote_id_t& node, const std::shared_ptr<io::socket<io::tcp>>& socket);
+
     // Synchronization
 
     void
@@ -0,0 +1,104 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_ENGINE_AUTOSCALER_HPP
+#define COCAINE_ENGINE_AUTOSCALER_HPP
+
+#include "cocaine/common.hpp"
+#include "cocaine/dynamic.hpp"
+
+#include "cocaine/detail/services/node/forwards.hpp"
+
+#include <mutex>
+
+namespace cocaine { namespace engine {
+
+// Predictive pool sizing. The autoscaler keeps exponentially weighted moving averages of the
+// session arrival rate, the session service time and the queue wait time, and derives the pool
+// size required to serve the observed load from Little's law: the number of sessions in service
+// is the arrival rate times the mean service time.
+
+class autoscaler_t {
+    COCAINE_DECLARE_NONCOPYABLE(autoscaler_t)
+
+public:
+    enum class decisions {
+        hold,
+        grow,
+        shrink
+    };
+
+    autoscaler_t(const profile_t& profile);
+
+    // Sampling
+
+    void
+    arrived();
+
+    void
+    started(double wait);
+
+    void
+    finished(double duration);
+
+    // Decision making
+
+    decisions
+    update(size_t pool, size_t depth);
+
+    size_t
+    target() const;
+
+    dynamic_t
+    info() const;
+
+private:
+    const profile_t& m_profile;
+
+    // Smoothing factor for a single sampling interval.
+    const double m_alpha;
+
+    // Samples collected over the current interval.
+    size_t m_arrivals;
+    size_t m_started;
+    size_t m_finished;
+
+    double m_wait_sum;
+    double m_duration_sum;
+
+    // Smoothed estimates.
+    double m_arrival_rate;
+    double m_queue_wait;
+    double m_service_time;
+
+    // Latest decision and its inputs.
+    size_t m_target;
+    decisions m_decision;
+
+    // For how long the pool has been larger than needed, in seconds.
+    float m_surplus;
+
+    mutable std::mutex m_mutex;
+};
+
+}} // namespace cocaine::engine
+
+#endif
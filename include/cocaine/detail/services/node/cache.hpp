@@ -0,0 +1,118 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_ENGINE_CACHE_HPP
+#define COCAINE_ENGINE_CACHE_HPP
+
+#include "cocaine/common.hpp"
+#include "cocaine/dynamic.hpp"
+
+#include "cocaine/detail/services/node/forwards.hpp"
+#include "cocaine/detail/services/node/session.hpp"
+
+#include <functional>
+#include <list>
+#include <mutex>
+
+namespace cocaine { namespace engine {
+
+// Response cache for idempotent events. Requests are keyed by the event name and the request body,
+// so the body is buffered until the client closes the request stream, unless it grows larger than
+// the body limit, in which case the request bypasses the cache. Then the response is either
+// replayed from the cache, or the request is handed over to the engine, while the response is
+// recorded on its way back to the client. Entries expire after their event TTL, and the least
+// recently used entries are evicted to keep the cache within its memory budget.
+
+class response_cache_t:
+    public std::enable_shared_from_this<response_cache_t>
+{
+    COCAINE_DECLARE_NONCOPYABLE(response_cache_t)
+
+public:
+    typedef std::vector<std::string> response_type;
+
+    typedef std::function<
+        std::shared_ptr<api::stream_t>(const std::shared_ptr<api::stream_t>&)
+    > handler_type;
+
+    response_cache_t(size_t capacity, size_t body_limit);
+
+    // Returns the request stream which should be passed to the client instead of the handler one.
+    std::shared_ptr<api::stream_t>
+    wrap(const std::string& event, float ttl, const std::shared_ptr<api::stream_t>& upstream, handler_type handler);
+
+    std::shared_ptr<const response_type>
+    get(const std::string& key);
+
+    void
+    put(const std::string& key, const std::shared_ptr<const response_type>& response, float ttl);
+
+    dynamic_t
+    info() const;
+
+public:
+    size_t
+    capacity() const {
+        return m_capacity;
+    }
+
+    size_t
+    body_limit() const {
+        return m_body_limit;
+    }
+
+private:
+    void
+    evict(size_t required);
+
+private:
+    const size_t m_capacity;
+
+    // Maximum request body size which is buffered to look the request up in the cache.
+    const size_t m_body_limit;
+
+    struct entry_t {
+        std::shared_ptr<const response_type> response;
+        session_t::clock_type::time_point expiration;
+        size_t footprint;
+        std::list<std::string>::iterator position;
+    };
+
+    typedef std::map<std::string, entry_t> entry_map_t;
+
+    entry_map_t m_entries;
+
+    // Keys in the order of their usage, the most recently used ones are at the front.
+    std::list<std::string> m_usage;
+
+    size_t m_size;
+
+    // Statistics.
+    size_t m_hits;
+    size_t m_misses;
+    size_t m_evictions;
+
+    mutable std::mutex m_mutex;
+};
+
+}} // namespace cocaine::engine
+
+#endif
@@ -28,8 +28,10 @@
 #include "cocaine/dynamic.hpp"
 
 #include "cocaine/detail/atomic.hpp"
+#include "cocaine/detail/snapshot.hpp"
 #include "cocaine/detail/services/node/forwards.hpp"
 #include "cocaine/detail/services/node/queue.hpp"
+#include "cocaine/detail/services/node/ring.hpp"
 
 #include <mutex>
 
@@ -45,18 +47,6 @@ namespace cocaine { namespace io {
 struct control_tag;
 
 struct control {
-    struct report {
-        typedef control_tag tag;
-    };
-
-    struct info {
-        typedef control_tag tag;
-
-        typedef boost::mpl::list<
-            /* info */ dynamic_t
-        > tuple_type;
-    };
-
     struct terminate {
         typedef control_tag tag;
     };
@@ -65,8 +55,6 @@ struct control {
 template<>
 struct protocol<control_tag> {
     typedef boost::mpl::list<
-        control::report,
-        control::info,
         control::terminate
     >::type messages;
 };
@@ -75,8 +63,13 @@ struct protocol<control_tag> {
 
 namespace engine {
 
+class autoscaler_t;
+class response_cache_t;
 class slave_t;
 
+struct event_statistics_t;
+struct session_t;
+
 class engine_t {
     COCAINE_DECLARE_NONCOPYABLE(engine_t)
 
@@ -106,6 +99,9 @@ class engine_t {
 
     std::unique_ptr<ev::async> m_notification;
     std::unique_ptr<ev::timer> m_termination_timer;
+    std::unique_ptr<ev::timer> m_autoscaling_timer;
+    std::unique_ptr<ev::timer> m_report_timer;
+    std::unique_ptr<ev::timer> m_steal_timer;
 
     // I/O
 
@@ -120,6 +116,9 @@ class engine_t {
 
     session_queue_t m_queue;
 
+    // Number of sessions taken back from the slave queues.
+    std::atomic<uint64_t> m_stolen;
+
     // Slave pool
 
     typedef std::map<
@@ -136,9 +135,36 @@ class engine_t {
 
     pool_map_t m_pool;
 
+    // Tag affinity ring over the regular slaves.
+    hash_ring_t m_ring;
+
     // Spawning mutex.
     std::mutex m_pool_mutex;
 
+    // Response caching
+
+    std::shared_ptr<response_cache_t> m_cache;
+
+    // Pool sizing
+
+    std::unique_ptr<autoscaler_t> m_autoscaler;
+
+    // Per-event latency and response size distributions, only accessed from the engine thread.
+
+    typedef std::map<
+        std::string,
+        std::unique_ptr<event_statistics_t>
+    > statistics_map_t;
+
+    statistics_map_t m_statistics;
+
+    // Periodically published engine report.
+    snapshot<dynamic_t> m_report;
+
+    // Queue depth and the number of active slaves as of the last report.
+    std::atomic<uint64_t> m_load_depth;
+    std::atomic<uint64_t> m_load_active;
+
     // NOTE: A strong isolate reference, keeping it here
     // avoids isolate destruction, as the factory stores
     // only weak references to the isolate instances.
@@ -170,10 +196,41 @@ public:
             const std::shared_ptr<api::stream_t>& upstream,
             const std::string& tag);
 
+    // Enqueues a batch of sessions under a single queue lock, the request streams are returned in
+    // the batch order.
+    std::vector<std::shared_ptr<api::stream_t>>
+    enqueue(const std::vector<api::event_t>& events,
+            const std::vector<std::shared_ptr<api::stream_t>>& upstreams);
+
+    // Removes a terminated slave from the pool, rescheduling the sessions it has never started.
     void
-    erase(const std::string& id, int code, const std::string& reason);
+    erase(const std::string& id,
+          int code,
+          const std::string& reason,
+          const std::deque<std::shared_ptr<session_t>>& pending);
+
+    // Accounting
+
+    void
+    started(const session_t& session);
+
+    void
+    finished(const session_t& session);
+
+    // Monitoring
+
+    std::shared_ptr<const dynamic_t>
+    info() const;
+
+    // Queue depth and the number of active slaves as of the last report.
+    std::tuple<uint64_t, uint64_t>
+    metrics() const;
 
 private:
+    std::shared_ptr<api::stream_t>
+    push(const api::event_t& event,
+         const std::shared_ptr<api::stream_t>& upstream);
+
     void
     on_connection(const std::shared_ptr<io::socket<io::local>>& socket);
 
@@ -192,6 +249,24 @@ private:
     void
     on_termination(ev::timer&, int);
 
+    void
+    on_autoscaling(ev::timer&, int);
+
+    void
+    on_report(ev::timer&, int);
+
+    void
+    on_steal(ev::timer&, int);
+
+    void
+    publish();
+
+    std::shared_ptr<slave_t>
+    affine(const std::string& tag);
+
+    void
+    requeue(const std::string& id, const std::deque<std::shared_ptr<session_t>>& pending);
+
     void
     pump();
 
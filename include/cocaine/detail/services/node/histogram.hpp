@@ -0,0 +1,99 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COCAINE_ENGINE_HISTOGRAM_HPP
+#define COCAINE_ENGINE_HISTOGRAM_HPP
+
+#include "cocaine/common.hpp"
+#include "cocaine/dynamic.hpp"
+
+#include "cocaine/detail/atomic.hpp"
+
+#include <array>
+
+namespace cocaine { namespace engine {
+
+// Log-linear histogram in the spirit of HdrHistogram. Each power of two range is split into a fixed
+// number of linear sub-buckets, so the relative error of any reported value is bounded by the
+// sub-bucket width (about 3%) regardless of the magnitude. Recording is lock-free.
+
+class histogram_t {
+    COCAINE_DECLARE_NONCOPYABLE(histogram_t)
+
+    enum: unsigned {
+        // Sub-buckets per power of two, as a power of two.
+        precision = 5,
+
+        // Values are clamped to this many bits.
+        magnitude = 40,
+
+        sub_buckets = 1U << precision,
+        buckets = (magnitude - precision + 1) * sub_buckets
+    };
+
+public:
+    histogram_t();
+
+    void
+    record(uint64_t value);
+
+    uint64_t
+    count() const;
+
+    // Returns the value at the given quantile, which must be in the [0, 1] range.
+    uint64_t
+    percentile(double quantile) const;
+
+    // Returns the count, the mean, the maximum and the commonly used percentiles.
+    dynamic_t
+    info() const;
+
+private:
+    static
+    unsigned
+    index(uint64_t value);
+
+    static
+    uint64_t
+    value(unsigned index);
+
+private:
+    std::array<std::atomic<uint64_t>, buckets> m_buckets;
+
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+};
+
+// Per-event session statistics. Times are measured in microseconds, sizes in bytes.
+
+struct event_statistics_t {
+    histogram_t queue_wait;
+    histogram_t first_chunk;
+    histogram_t duration;
+    histogram_t response_size;
+
+    dynamic_t
+    info() const;
+};
+
+}} // namespace cocaine::engine
+
+#endif
@@ -0,0 +1,73 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COCAINE_ENGINE_LIMITER_HPP
+#define COCAINE_ENGINE_LIMITER_HPP
+
+#include "cocaine/common.hpp"
+
+#include "cocaine/detail/atomic.hpp"
+
+namespace cocaine { namespace engine {
+
+// Adaptive concurrency limit, in the spirit of TCP Vegas. The limiter compares the mean session
+// latency over a window of completions with the lowest latency observed recently, which estimates
+// the latency of an unloaded slave. While the two stay within the tolerance, the limit is grown
+// additively, otherwise it's cut in proportion to the latency increase.
+
+class limiter_t {
+    COCAINE_DECLARE_NONCOPYABLE(limiter_t)
+
+public:
+    limiter_t(size_t min, size_t max, double tolerance);
+
+    // Accounts a completed session, given its latency and the number of sessions which were in
+    // progress at that moment, including the completed one.
+    void
+    update(double latency, size_t load);
+
+    size_t
+    limit() const {
+        return m_limit.load(std::memory_order_relaxed);
+    }
+
+private:
+    const size_t m_min;
+    const size_t m_max;
+    const double m_tolerance;
+
+    std::atomic<size_t> m_limit;
+
+    // Samples collected over the current window.
+    size_t m_samples;
+    double m_latency_sum;
+    double m_latency_min;
+
+    // Whether the limit has actually been reached during the current window.
+    bool m_saturated;
+
+    // Estimated unloaded latency and the number of windows it has been in use for.
+    double m_baseline;
+    size_t m_baseline_age;
+};
+
+}} // namespace cocaine::engine
+
+#endif
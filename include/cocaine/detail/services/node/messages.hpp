@@ -32,8 +32,14 @@ struct rpc {
 struct handshake {
     typedef rpc_tag tag;
 
+    // Optional protocol features supported by the slave.
+    enum features: uint64_t {
+        shared_memory = 1
+    };
+
     typedef boost::mpl::list<
-        /* peer id */ std::string
+        /* peer id */  std::string,
+        /* features */ optional<uint64_t>
     > tuple_type;
 };
 
@@ -84,6 +90,29 @@ struct choke {
     typedef rpc_tag tag;
 };
 
+// Sent to the slaves which support the shared memory data plane right after the handshake, with
+// two shared memory ring descriptors attached: for the engine to slave and the slave to engine
+// payloads. Chunks larger than the threshold are then placed into the rings, and only their
+// positions are sent over the channel.
+
+struct mapping {
+    typedef rpc_tag tag;
+
+    typedef boost::mpl::list<
+        /* capacity */  uint64_t,
+        /* threshold */ uint64_t
+    > tuple_type;
+};
+
+struct mapped_chunk {
+    typedef rpc_tag tag;
+
+    typedef boost::mpl::list<
+        /* offset */ uint64_t,
+        /* size */   uint64_t
+    > tuple_type;
+};
+
 }; // struct rpc
 
 template<>
@@ -99,7 +128,9 @@ struct protocol<rpc_tag> {
         rpc::invoke,
         rpc::chunk,
         rpc::error,
-        rpc::choke
+        rpc::choke,
+        rpc::mapping,
+        rpc::mapped_chunk
     >::type messages;
 };
 
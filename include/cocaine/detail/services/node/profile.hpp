@@ -22,10 +22,13 @@
 #define COCAINE_ENGINE_PROFILE_HPP
 
 #include "cocaine/common.hpp"
+#include "cocaine/detail/affinity.hpp"
 #include "cocaine/detail/cached.hpp"
 
 #include "cocaine/dynamic.hpp"
 
+#include <set>
+
 namespace cocaine { namespace engine {
 
 struct profile_t:
@@ -45,6 +48,13 @@ struct profile_t:
     float startup_timeout;
     float termination_timeout;
 
+    // How often the engine report is refreshed.
+    float report_interval;
+
+    // How long a session can wait for a busy or starting slave before the engine gives it to some
+    // other slave, zero disables it.
+    float steal_threshold;
+
     // Limits.
     unsigned long concurrency;
     unsigned long crashlog_limit;
@@ -52,6 +62,55 @@ struct profile_t:
     unsigned long pool_limit;
     unsigned long queue_limit;
 
+    // Adaptive concurrency: each slave limit floats between the lower bound and the concurrency
+    // above, depending on how much the session latency exceeds the unloaded one.
+    struct {
+        bool  enabled;
+        unsigned long min;
+        float tolerance;
+    } adaptive_concurrency;
+
+    // Response caching: the cache memory budget, the maximum size of the request bodies which are
+    // looked up in the cache and the cached events with their TTLs.
+    struct {
+        unsigned long size;
+        unsigned long body_limit;
+        std::map<std::string, float> events;
+    } cache;
+
+    // Request coalescing: identical concurrent requests for these events share one invocation.
+    std::set<std::string> coalesce;
+
+    // Shared memory data plane: the ring capacity for each direction, zero disables it, and the
+    // minimal size of the chunks which are passed via the rings.
+    unsigned long shared_memory;
+    unsigned long shared_memory_threshold;
+
+    // Tagged sessions are either served by a dedicated slave per tag, or spread over the regular
+    // pool via a consistent hash ring, so that sessions with the same tag share a warm slave.
+    bool hashed_affinity;
+
+    // Predictive pool sizing: the sampling interval, the smoothing window, the target slave
+    // utilization and the delay before an oversized pool starts shrinking.
+    struct {
+        bool  enabled;
+        float interval;
+        float window;
+        float utilization;
+        float cooldown;
+    } autoscaling;
+
+    // Load shedding: the acceptable queue wait and the interval it can be exceeded for before the
+    // engine starts rejecting new sessions.
+    struct {
+        bool  enabled;
+        float target;
+        float interval;
+    } shedding;
+
+    // The CPU set for the engine thread.
+    affinity_t cpu_affinity;
+
     // NOTE: The slave processes are launched in sandboxed environments,
     // called isolates. This one describes the isolate type and arguments.
     config_t::component_t isolate;
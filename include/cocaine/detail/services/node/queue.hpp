@@ -21,6 +21,9 @@
 #ifndef COCAINE_ENGINE_QUEUE_HPP
 #define COCAINE_ENGINE_QUEUE_HPP
 
+#include "cocaine/common.hpp"
+
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -32,9 +35,41 @@ struct session_t;
 struct session_queue_t:
     public std::deque<std::shared_ptr<session_t>>
 {
+#if defined(__clang__) || defined(HAVE_GCC47)
+    typedef std::chrono::steady_clock clock_type;
+#else
+    typedef std::chrono::monotonic_clock clock_type;
+#endif
+
+    session_queue_t();
+
     void
     push(const_reference session);
 
+    // Removes the queue head, sampling its queue wait time.
+    value_type
+    pop();
+
+    // Controlled delay admission, modeled after the server flavor of CoDel. The queue is considered
+    // overloaded when even the shortest wait time sampled on dequeue over a whole interval exceeds
+    // the target, i.e. there's a standing queue. Every new session is rejected while overloaded.
+
+    void
+    control(double target, double interval);
+
+    bool
+    admit();
+
+    bool
+    shedding() const {
+        return m_overloaded;
+    }
+
+    uint64_t
+    shed() const {
+        return m_shed;
+    }
+
     // Lockable concept implementation
 
     void
@@ -47,8 +82,23 @@ struct session_queue_t:
         m_mutex.unlock();
     }
 
+private:
+    void
+    sample(clock_type::time_point now, clock_type::duration sojourn);
+
 private:
     std::mutex m_mutex;
+
+    // Controlled delay state, disabled when the target is zero.
+    clock_type::duration m_target;
+    clock_type::duration m_interval;
+
+    // The shortest wait time sampled since the current interval has started.
+    clock_type::duration m_min_delay;
+    clock_type::time_point m_interval_end;
+
+    bool m_overloaded;
+    uint64_t m_shed;
 };
 
 }} // namespace cocaine::engine
@@ -0,0 +1,83 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_ENGINE_RING_HPP
+#define COCAINE_ENGINE_RING_HPP
+
+#include "cocaine/common.hpp"
+
+#include <functional>
+
+namespace cocaine { namespace engine {
+
+// Consistent hash ring. Every member is mapped onto the ring at multiple points, so that keys are
+// evenly spread across the members, and only the keys of the affected member are remapped when a
+// member joins or leaves the ring.
+
+class hash_ring_t {
+    typedef std::map<size_t, std::string> ring_map_t;
+
+    ring_map_t m_ring;
+
+    std::hash<std::string> m_hash;
+
+public:
+    void
+    insert(const std::string& id);
+
+    void
+    erase(const std::string& id);
+
+    void
+    clear();
+
+    // Walks the ring clockwise starting from the key position, and returns the first member which
+    // satisfies the predicate, or nullptr if there's no such member.
+    template<class Predicate>
+    const std::string*
+    find(const std::string& key, Predicate predicate) const;
+};
+
+template<class Predicate>
+const std::string*
+hash_ring_t::find(const std::string& key, Predicate predicate) const {
+    if(m_ring.empty()) {
+        return nullptr;
+    }
+
+    ring_map_t::const_iterator it = m_ring.lower_bound(m_hash(key));
+
+    for(size_t step = 0; step != m_ring.size(); ++step, ++it) {
+        if(it == m_ring.end()) {
+            it = m_ring.begin();
+        }
+
+        if(predicate(it->second)) {
+            return &it->second;
+        }
+    }
+
+    return nullptr;
+}
+
+}} // namespace cocaine::engine
+
+#endif
@@ -32,11 +32,21 @@
 
 #include "cocaine/rpc/encoder.hpp"
 
+#include <chrono>
+
 namespace cocaine { namespace engine {
 
+class shared_ring_t;
+
 struct session_t {
     COCAINE_DECLARE_NONCOPYABLE(session_t)
 
+#if defined(__clang__) || defined(HAVE_GCC47)
+    typedef std::chrono::steady_clock clock_type;
+#else
+    typedef std::chrono::monotonic_clock clock_type;
+#endif
+
     session_t(uint64_t id, const api::event_t& event, const api::stream_ptr_t& upstream);
 
     struct downstream_t:
@@ -66,6 +76,14 @@ struct session_t {
     void
     attach(const std::shared_ptr<io::writable_stream<io::socket<io::local>>>& downstream);
 
+    void
+    attach(const std::shared_ptr<io::writable_stream<io::socket<io::local>>>& downstream,
+           const std::shared_ptr<shared_ring_t>& ring,
+           size_t threshold);
+
+    void
+    write(const char* chunk, size_t size);
+
     void
     detach();
 
@@ -82,6 +100,24 @@ public:
     // Client's upstream for response delivery.
     const std::shared_ptr<api::stream_t> upstream;
 
+    // Whether the session must be processed by the slave dedicated to its tag.
+    bool pinned;
+
+    // Number of times the session has been rescheduled after its slave has died.
+    unsigned int requeues;
+
+    // Time points of the session creation and of its assignment to a slave.
+    const clock_type::time_point birthstamp;
+    clock_type::time_point attachstamp;
+
+    // Time point of the session entering its current queue, either the engine queue or the backlog
+    // of some slave. Queueing delays are measured against this one, as sessions move between them.
+    clock_type::time_point queuestamp;
+
+    // Time point of the first response chunk and the total response size so far.
+    clock_type::time_point replystamp;
+    uint64_t reply_size;
+
 private:
     template<class Event, typename... Args>
     void
@@ -92,6 +128,10 @@ private:
         io::encoder<io::writable_stream<io::socket<io::local>>>
     > m_encoder;
 
+    // Shared memory ring for large chunks, if the slave supports it.
+    std::shared_ptr<shared_ring_t> m_ring;
+    size_t m_threshold;
+
     // Session interlocking.
     std::mutex m_mutex;
 
@@ -0,0 +1,90 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_ENGINE_SHARED_RING_HPP
+#define COCAINE_ENGINE_SHARED_RING_HPP
+
+#include "cocaine/common.hpp"
+
+#include <mutex>
+
+namespace cocaine { namespace engine {
+
+// Single producer, single consumer byte ring in an anonymous shared memory file. The producer
+// places a payload into the ring and sends its position to the consumer over the regular channel,
+// the consumer then releases the space, in the same order. Positions are virtual offsets, which
+// grow monotonically, the ring never splits a payload but skips the tail space instead.
+
+class shared_ring_t {
+    COCAINE_DECLARE_NONCOPYABLE(shared_ring_t)
+
+    struct header_t;
+
+    const size_t m_capacity;
+
+    int m_fd;
+
+    header_t* m_header;
+    char* m_data;
+
+    // Producer interlocking.
+    std::mutex m_mutex;
+
+public:
+    shared_ring_t(size_t capacity);
+
+   ~shared_ring_t();
+
+    // Producer side
+
+    bool
+    write(const char* data, size_t size, uint64_t& offset);
+
+    // Consumer side
+
+    const char*
+    read(uint64_t offset, size_t size) const;
+
+    void
+    release(uint64_t offset, size_t size);
+
+public:
+    int
+    fd() const {
+        return m_fd;
+    }
+
+    // Lockable concept implementation
+
+    void
+    lock() {
+        m_mutex.lock();
+    }
+
+    void
+    unlock() {
+        m_mutex.unlock();
+    }
+};
+
+}} // namespace cocaine::engine
+
+#endif
@@ -27,6 +27,7 @@
 
 #include "cocaine/detail/atomic.hpp"
 #include "cocaine/detail/services/node/forwards.hpp"
+#include "cocaine/detail/services/node/limiter.hpp"
 #include "cocaine/detail/services/node/queue.hpp"
 
 #include <chrono>
@@ -39,6 +40,8 @@ namespace ev {
 
 namespace cocaine { namespace engine {
 
+class shared_ring_t;
+
 struct session_t;
 
 class slave_t {
@@ -76,11 +79,17 @@ class slave_t {
     states m_state;
 
 #if defined(__clang__) || defined(HAVE_GCC47)
-    const std::chrono::steady_clock::time_point m_birthstamp;
+    typedef std::chrono::steady_clock clock_type;
 #else
-    const std::chrono::monotonic_clock::time_point m_birthstamp;
+    typedef std::chrono::monotonic_clock clock_type;
 #endif
 
+    const clock_type::time_point m_birthstamp;
+
+    // Total time spent with at least one active session, not counting the current busy period.
+    clock_type::duration m_busy_time;
+    clock_type::time_point m_busy_since;
+
     std::unique_ptr<ev::timer> m_heartbeat_timer;
     std::unique_ptr<ev::timer> m_idle_timer;
 
@@ -93,12 +102,16 @@ class slave_t {
     struct pipe_t;
 
     std::unique_ptr<io::readable_stream<pipe_t>> m_output_pipe;
-    boost::circular_buffer<std::string> m_output_ring;
+    boost::circular_buffer<char> m_output_ring;
 
     // I/O channel
 
     std::shared_ptr<io::channel<io::socket<io::local>>> m_channel;
 
+    // Shared memory rings for the outgoing and incoming chunks.
+    std::shared_ptr<shared_ring_t> m_tx_ring;
+    std::unique_ptr<shared_ring_t> m_rx_ring;
+
     // Active sessions
 
     typedef std::map<
@@ -112,9 +125,13 @@ class slave_t {
 
     session_queue_t m_queue;
 
+    // Concurrency limit
+
+    limiter_t m_limiter;
+
     // Slave interlocking
 
-    std::mutex m_mutex;
+    mutable std::mutex m_mutex;
 
 public:
     slave_t(context_t& context,
@@ -131,11 +148,19 @@ public:
     void
     bind(const std::shared_ptr<io::channel<io::socket<io::local>>>& channel);
 
+    void
+    share(int fd);
+
     // Session scheduling
 
     void
     assign(const std::shared_ptr<session_t>& session);
 
+    // Takes back the queued sessions which are not pinned to this slave and have entered its queue
+    // before the given time point.
+    std::vector<std::shared_ptr<session_t>>
+    steal(session_queue_t::clock_type::time_point threshold);
+
     // Termination
 
     void
@@ -152,6 +177,15 @@ public:
         return m_sessions.size();
     }
 
+    size_t
+    limit() const {
+        return m_limiter.limit();
+    }
+
+    // Fraction of the slave lifetime spent processing sessions.
+    double
+    utilization() const;
+
 private:
     void
     on_message(const io::message_t& message);
@@ -168,7 +202,10 @@ private:
     on_death(int code, const std::string& reason);
 
     void
-    on_chunk(uint64_t session_id, const std::string& chunk);
+    on_chunk(uint64_t session_id, const char* chunk, size_t size);
+
+    void
+    on_mapped_chunk(uint64_t session_id, uint64_t offset, uint64_t size);
 
     void
     on_error(uint64_t session_id, int code, const std::string& reason);
@@ -0,0 +1,100 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COCAINE_SNAPSHOT_HPP
+#define COCAINE_SNAPSHOT_HPP
+
+#include "cocaine/common.hpp"
+
+#include "cocaine/detail/atomic.hpp"
+
+#include <memory>
+
+namespace cocaine {
+
+// An immutable value which is published by a writer and read by any number of readers. Readers get
+// a reference to a complete value and never wait for the writer to build the next one: the only
+// synchronization is a spinlock around the pointer copy itself.
+//
+// NOTE: This is basically std::atomic_load() and std::atomic_store() for shared pointers, which
+// are not available on the supported compilers, and are implemented with a mutex pool anyway.
+
+template<class T>
+class snapshot {
+    COCAINE_DECLARE_NONCOPYABLE(snapshot)
+
+public:
+    typedef std::shared_ptr<const T> pointer_type;
+
+    snapshot() {
+        m_lock.clear();
+    }
+
+    explicit
+    snapshot(const pointer_type& value):
+        m_value(value)
+    {
+        m_lock.clear();
+    }
+
+    pointer_type
+    load() const {
+        acquire();
+
+        pointer_type value = m_value;
+
+        release();
+
+        return value;
+    }
+
+    void
+    store(pointer_type value) {
+        acquire();
+
+        m_value.swap(value);
+
+        release();
+
+        // The previous value, if it's not in use anymore, is destroyed outside of the lock.
+    }
+
+private:
+    void
+    acquire() const {
+        while(m_lock.test_and_set(std::memory_order_acquire)) {
+            // Spin.
+        }
+    }
+
+    void
+    release() const {
+        m_lock.clear(std::memory_order_release);
+    }
+
+private:
+    mutable std::atomic_flag m_lock;
+
+    pointer_type m_value;
+};
+
+} // namespace cocaine
+
+#endif
@@ -0,0 +1,72 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_WORKER_POOL_HPP
+#define COCAINE_WORKER_POOL_HPP
+
+#include "cocaine/common.hpp"
+
+#include <functional>
+#include <limits>
+
+#define BOOST_BIND_NO_PLACEHOLDERS
+#include <boost/thread/thread.hpp>
+
+namespace cocaine {
+
+// A fixed-size pool of threads to run blocking tasks off the reactor threads. The tasks are run in
+// the FIFO order, as soon as some thread becomes available. Tasks posted with the same non-null key,
+// e.g. the calls from the same client connection, are never run concurrently and keep their order.
+
+class worker_pool_t {
+    COCAINE_DECLARE_NONCOPYABLE(worker_pool_t)
+
+    struct state_t;
+    struct worker_t;
+
+    // NOTE: The state is shared with the threads, so that the pool could be destroyed from within
+    // one of its own tasks, in which case the thread is detached and exits after the task is done.
+    const std::shared_ptr<state_t> m_state;
+
+    std::vector<std::unique_ptr<boost::thread>> m_threads;
+
+public:
+    worker_pool_t(const std::string& name, size_t size, size_t limit = std::numeric_limits<size_t>::max());
+   ~worker_pool_t();
+
+    // Returns false if the task has been rejected because there are already too many of them
+    // waiting for a thread.
+    bool
+    post(const void* key, const std::function<void()>& task);
+
+    bool
+    post(const std::function<void()>& task) {
+        return post(nullptr, task);
+    }
+
+    // Number of tasks waiting for a thread.
+    size_t
+    pending() const;
+};
+
+} // namespace cocaine
+
+#endif
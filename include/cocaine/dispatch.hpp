@@ -24,17 +24,23 @@
 #include "cocaine/common.hpp"
 
 #include "cocaine/rpc/slots/blocking.hpp"
+#include "cocaine/rpc/slots/coroutine.hpp"
 #include "cocaine/rpc/slots/deferred.hpp"
 #include "cocaine/rpc/slots/streamed.hpp"
 
 #include "cocaine/rpc/traversal.hpp"
 
+#include "cocaine/idl/locator.hpp"
+
+#include <boost/optional.hpp>
+
 #include <boost/mpl/apply.hpp>
 #include <boost/mpl/empty.hpp>
 
 namespace cocaine {
 
 class upstream_t;
+class worker_pool_t;
 
 namespace io { namespace aux {
 
@@ -65,6 +71,9 @@ class dispatch_t {
     // For actor's named threads feature.
     const std::string m_name;
 
+    // Optional thread pool to run the blocking slots on, so that they won't stall the reactor.
+    std::unique_ptr<worker_pool_t> m_workers;
+
 public:
     dispatch_t(context_t& context, const std::string& name);
 
@@ -83,6 +92,12 @@ public:
     void
     forget();
 
+    // Makes the blocking slots run on a pool of the given number of threads. Calls from the same
+    // connection are run one at a time in order, and at most the given number of calls can wait for
+    // a thread, the rest are failed right away.
+    void
+    offload(size_t workers, size_t limit);
+
 public:
     std::shared_ptr<dispatch_t>
     invoke(const message_t& message, const std::shared_ptr<upstream_t>& upstream) const;
@@ -95,6 +110,12 @@ public:
     int
     versions() const = 0;
 
+    // Load metrics announced to the other nodes: the number of queued requests and the number of
+    // active workers. Services which have no notion of load don't have to override it.
+    virtual
+    auto
+    load() const -> boost::optional<io::locator::synchronize::load_tuple_type>;
+
     std::string
     name() const;
 };
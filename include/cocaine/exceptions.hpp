@@ -32,7 +32,8 @@ enum error_code {
     invocation_error = 1,
     resource_error,
     timeout_error,
-    deadline_error
+    deadline_error,
+    overload_error
 };
 
 struct error_t:
@@ -78,10 +78,29 @@ struct synchronize {
         return "synchronize";
     }
 
+    typedef std::tuple<
+     /* Number of requests waiting in the service queue. */
+        uint64_t,
+     /* Number of service workers which are currently active. */
+        uint64_t
+    > load_tuple_type;
+
     typedef stream_of<
-     /* A full dump of all available services on this node. Used by metalocator to aggregate
-        node information from the cluster. */
-        std::map<std::string, tuple::fold<resolve::value_type>::type>
+     /* Update version. Versions are consecutive within a single synchronization stream, so a gap
+        means that some updates have been lost and the whole stream has to be restarted. */
+        uint64_t,
+     /* Whether this update is a full dump of all available services on this node, which replaces
+        everything known about it, or a delta against the previous update. The first update in
+        the stream is always a full dump. Used by metalocator to aggregate node information from
+        the cluster. */
+        bool,
+     /* Services which have been published since the previous update. */
+        std::map<std::string, tuple::fold<resolve::value_type>::type>,
+     /* Services which have been withdrawn since the previous update. */
+        std::vector<std::string>,
+     /* Load metrics of the services, for the gateways to steer the clients away from the busy
+        nodes. Services which have no notion of load are omitted. */
+        std::map<std::string, load_tuple_type>
     >::tag drain_type;
 };
 
@@ -95,7 +114,8 @@ struct reports {
     }
 
     typedef stream_of<
-     /* Service I/O usage counters: number of concurrent sessions and memory footprints. */
+     /* Runtime I/O usage counters. Execution units are listed under the 'execution' key with their
+        number of connections and the number of messages they have handled. */
         std::map<std::string, std::map<std::string, std::tuple<size_t, size_t>>>
     >::tag drain_type;
 };
@@ -120,7 +140,7 @@ struct refresh {
 template<>
 struct protocol<locator_tag> {
     typedef boost::mpl::int_<
-        2
+        4
     >::type version;
 
     typedef boost::mpl::list<
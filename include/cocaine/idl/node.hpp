@@ -57,6 +57,41 @@ struct enqueue {
     >::tag drain_type;
 };
 
+struct enqueue_batch {
+    typedef app_tag tag;
+
+    static
+    const char*
+    alias() {
+        return "enqueue_batch";
+    }
+
+    // Frame types of the batch results.
+    enum frames: int {
+        chunk =  0,
+        error =  1,
+        choke = -1
+    };
+
+    typedef boost::mpl::list<
+     /* Batch entries, each one is an event name and the complete request body for it. */
+        std::vector<std::pair<std::string, std::string>>,
+     /* Tag. The whole batch is enqueued to a specific worker with some user-defined name. */
+        optional<std::string>
+    > tuple_type;
+
+    typedef stream_of<
+     /* Index of the batch entry this frame belongs to. Frames of different entries interleave. */
+        uint64_t,
+     /* Frame type: a response chunk, an error or the entry completion marker. */
+        int,
+     /* Error code for the error frames, zero otherwise. */
+        int,
+     /* Response chunk or error description, empty for the completion marker. */
+        std::string
+    >::tag drain_type;
+};
+
 struct info {
     typedef app_tag tag;
 
@@ -82,7 +117,8 @@ struct protocol<app_tag> {
 
     typedef boost::mpl::list<
         app::enqueue,
-        app::info
+        app::info,
+        app::enqueue_batch
     > messages;
 
     typedef app type;
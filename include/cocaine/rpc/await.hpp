@@ -0,0 +1,292 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_IO_AWAIT_HPP
+#define COCAINE_IO_AWAIT_HPP
+
+#include "cocaine/common.hpp"
+
+#include "cocaine/asio/reactor.hpp"
+
+#include "cocaine/detail/atomic.hpp"
+#include "cocaine/detail/coroutine.hpp"
+#include "cocaine/detail/workers.hpp"
+
+#include <exception>
+
+#include <boost/optional.hpp>
+
+namespace cocaine { namespace io {
+
+// Helpers for coroutine slots: an asynchronous operation is given a completion handler, and the
+// coroutine is suspended until the handler is invoked, possibly from some other thread. If the
+// operation drops the handler without invoking it, the coroutine is resumed with an error, so that
+// its stack is properly unwound.
+
+namespace aux {
+
+template<class T>
+struct await_state {
+    std::exception_ptr error;
+    boost::optional<T> value;
+
+    T
+    get() {
+        return std::move(*value);
+    }
+};
+
+template<>
+struct await_state<void> {
+    std::exception_ptr error;
+
+    void
+    get() { }
+};
+
+template<class T>
+struct await_handle {
+    await_handle(const std::shared_ptr<coroutine_t>& coroutine_, const std::shared_ptr<await_state<T>>& state_):
+        coroutine(coroutine_),
+        state(state_),
+        fired(false)
+    { }
+
+   ~await_handle() {
+        if(fired) {
+            return;
+        }
+
+        try {
+            throw cocaine::error_t("asynchronous operation has been abandoned");
+        } catch(...) {
+            state->error = std::current_exception();
+        }
+
+        coroutine->schedule();
+    }
+
+    // Returns true only for the first completion attempt.
+    bool
+    fire() {
+        return !fired.exchange(true);
+    }
+
+    const std::shared_ptr<coroutine_t> coroutine;
+    const std::shared_ptr<await_state<T>> state;
+
+    std::atomic<bool> fired;
+};
+
+} // namespace aux
+
+template<class T>
+class completion {
+    std::shared_ptr<aux::await_handle<T>> m_handle;
+
+public:
+    completion(const std::shared_ptr<coroutine_t>& coroutine, const std::shared_ptr<aux::await_state<T>>& state):
+        m_handle(std::make_shared<aux::await_handle<T>>(coroutine, state))
+    { }
+
+    void
+    operator()(const T& value) const {
+        if(m_handle->fire()) {
+            m_handle->state->value = value;
+            m_handle->coroutine->schedule();
+        }
+    }
+
+    void
+    abort(const std::exception_ptr& error) const {
+        if(m_handle->fire()) {
+            m_handle->state->error = error;
+            m_handle->coroutine->schedule();
+        }
+    }
+};
+
+template<>
+class completion<void> {
+    std::shared_ptr<aux::await_handle<void>> m_handle;
+
+public:
+    completion(const std::shared_ptr<coroutine_t>& coroutine, const std::shared_ptr<aux::await_state<void>>& state):
+        m_handle(std::make_shared<aux::await_handle<void>>(coroutine, state))
+    { }
+
+    void
+    operator()() const {
+        if(m_handle->fire()) {
+            m_handle->coroutine->schedule();
+        }
+    }
+
+    void
+    abort(const std::exception_ptr& error) const {
+        if(m_handle->fire()) {
+            m_handle->state->error = error;
+            m_handle->coroutine->schedule();
+        }
+    }
+};
+
+// Starts the operation, passing it a completion<T> handler, and suspends the current coroutine
+// until the operation is completed. Any exception the operation has been aborted with is rethrown.
+
+template<class T, class Operation>
+T
+await(const Operation& operation) {
+    coroutine_t* self = coroutine_t::current();
+
+    if(self == nullptr) {
+        throw cocaine::error_t("unable to await outside of a coroutine");
+    }
+
+    const auto state = std::make_shared<aux::await_state<T>>();
+
+    operation(completion<T>(self->shared_from_this(), state));
+
+    // NOTE: The coroutine always runs on the reactor thread, and the completion always resumes it
+    // via the reactor, so it can't be resumed before it is actually suspended here.
+    self->suspend();
+
+    if(state->error) {
+        std::rethrow_exception(state->error);
+    }
+
+    return state->get();
+}
+
+namespace aux {
+
+struct sleep_operation {
+    sleep_operation(reactor_t& reactor, float timeout_):
+        timer(reactor.native()),
+        timeout(timeout_)
+    { }
+
+    void
+    operator()(const completion<void>& handler) const {
+        done = handler;
+
+        timer.set<sleep_operation, &sleep_operation::on_timer>(const_cast<sleep_operation*>(this));
+        timer.start(timeout);
+    }
+
+    void
+    on_timer(ev::timer&, int) {
+        timer.stop();
+
+        // Release the handler right away, as the operation outlives the completion.
+        const completion<void> handler = *done;
+
+        done.reset();
+        handler();
+    }
+
+    mutable ev::timer timer;
+    mutable boost::optional<completion<void>> done;
+
+    const float timeout;
+};
+
+template<class R>
+struct offload_task {
+    void
+    operator()() const {
+        try {
+            done(callable());
+        } catch(...) {
+            done.abort(std::current_exception());
+        }
+    }
+
+    const std::function<R()> callable;
+    const completion<R> done;
+};
+
+template<>
+struct offload_task<void> {
+    void
+    operator()() const {
+        try {
+            callable();
+            done();
+        } catch(...) {
+            done.abort(std::current_exception());
+        }
+    }
+
+    const std::function<void()> callable;
+    const completion<void> done;
+};
+
+template<class R>
+struct offload_operation {
+    void
+    operator()(const completion<R>& handler) const {
+        if(pool.post(offload_task<R>{callable, handler})) {
+            return;
+        }
+
+        try {
+            throw cocaine::error_t("the worker queue is full");
+        } catch(...) {
+            handler.abort(std::current_exception());
+        }
+    }
+
+    worker_pool_t& pool;
+    const std::function<R()> callable;
+};
+
+} // namespace aux
+
+// Suspends the current coroutine for the given number of seconds.
+
+inline
+void
+sleep_for(float timeout) {
+    coroutine_t* self = coroutine_t::current();
+
+    if(self == nullptr) {
+        throw cocaine::error_t("unable to sleep outside of a coroutine");
+    }
+
+    // NOTE: The operation lives on the coroutine stack, which is intact until it is resumed.
+    const aux::sleep_operation operation(self->reactor(), timeout);
+
+    await<void>(operation);
+}
+
+// Runs a blocking call, like a storage read, on the worker pool and suspends the current coroutine
+// until it is done.
+
+template<class R>
+R
+offload(worker_pool_t& pool, const std::function<R()>& callable) {
+    return await<R>(aux::offload_operation<R>{pool, callable});
+}
+
+}} // namespace cocaine::io
+
+#endif
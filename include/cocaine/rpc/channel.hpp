@@ -75,6 +75,11 @@ public:
         return m_socket->remote_endpoint();
     }
 
+    auto
+    socket() const -> const std::shared_ptr<Socket>& {
+        return m_socket;
+    }
+
     size_t
     footprint() const {
         if (rd->stream() && wr->stream()) {
@@ -87,6 +87,27 @@ struct encoder {
         }
     }
 
+    // Writes a message with the arguments already packed into a msgpack array, so that the same
+    // message could be sent over multiple channels without packing it over and over again.
+    template<class Event>
+    void
+    write_packed(uint64_t stream, const char* args, size_t size) {
+        typedef event_traits<Event> traits;
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        m_packer.pack_array(3);
+        m_packer.pack_uint64(stream);
+        m_packer.pack_uint32(traits::id);
+
+        m_buffer.write(args, size);
+
+        if(m_stream) {
+            m_stream->write(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+        }
+    }
+
 public:
     std::shared_ptr<stream_type>
     stream() {
@@ -61,6 +61,16 @@ public:
     void
     detach();
 
+    // Detaches the connection if the session is idle, i.e. has neither open virtual channels nor
+    // any buffered traffic, so that the connection could be served by some other session.
+    std::shared_ptr<io::socket<io::tcp>>
+    release();
+
+    auto
+    dispatch() const -> const std::shared_ptr<io::dispatch_t>& {
+        return prototype;
+    }
+
 private:
     void
     revoke(uint64_t index);
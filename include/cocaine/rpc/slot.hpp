@@ -39,6 +39,14 @@ struct slot_concept_t {
     std::shared_ptr<dispatch_t>
     operator()(const msgpack::object& unpacked, const std::shared_ptr<upstream_t>& upstream) = 0;
 
+    // Blocking slots might be run outside of the reactor thread, given that their dispatch has a
+    // worker pool. Such slots must deliver all their results via the upstream.
+    virtual
+    bool
+    blocking() const {
+        return false;
+    }
+
 public:
     std::string
     name() const {
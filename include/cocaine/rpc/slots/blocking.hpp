@@ -58,6 +58,12 @@ struct blocking_slot:
         // Return an empty protocol dispatch.
         return std::shared_ptr<dispatch_t>();
     }
+
+    virtual
+    bool
+    blocking() const {
+        return true;
+    }
 };
 
 // Blocking slot specialization for void functions
@@ -92,6 +98,12 @@ struct blocking_slot<Event, void>:
         // Return an empty protocol dispatch.
         return std::shared_ptr<dispatch_t>();
     }
+
+    virtual
+    bool
+    blocking() const {
+        return true;
+    }
 };
 
 }} // namespace cocaine::io
@@ -0,0 +1,173 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COCAINE_IO_COROUTINE_SLOT_HPP
+#define COCAINE_IO_COROUTINE_SLOT_HPP
+
+#include "cocaine/rpc/await.hpp"
+
+#include "cocaine/rpc/slots/function.hpp"
+
+namespace cocaine { namespace io {
+
+// Coroutine slot. The callable is run in a coroutine on the given reactor, so it may await timers,
+// blocking calls offloaded to a worker pool or any other asynchronous operations without blocking
+// the reactor. The result is sent to the upstream when the callable returns.
+
+namespace aux {
+
+template<class Slot>
+struct coroutine_body {
+    void
+    operator()() const {
+        msgpack::zone zone;
+        msgpack::object unpacked;
+
+        size_t offset = 0;
+
+        msgpack::unpack(buffer->data(), buffer->size(), &offset, &zone, &unpacked);
+
+        slot->invoke(unpacked, upstream);
+    }
+
+    const std::shared_ptr<const Slot> slot;
+    const std::shared_ptr<msgpack::sbuffer> buffer;
+    const std::shared_ptr<upstream_t> upstream;
+};
+
+} // namespace aux
+
+template<
+    class Event,
+    class R = typename result_of<Event>::type
+>
+struct coroutine_slot:
+    public function_slot<Event, R>,
+    public std::enable_shared_from_this<coroutine_slot<Event, R>>
+{
+    typedef function_slot<Event, R> parent_type;
+
+    typedef typename parent_type::callable_type callable_type;
+    typedef typename parent_type::protocol_type protocol;
+
+    coroutine_slot(reactor_t& reactor, callable_type callable, size_t stack_size = coroutine_t::default_stack_size):
+        parent_type(callable),
+        m_reactor(reactor),
+        m_stack_size(stack_size)
+    { }
+
+    virtual
+    std::shared_ptr<dispatch_t>
+    operator()(const msgpack::object& unpacked, const std::shared_ptr<upstream_t>& upstream) {
+        // NOTE: The arguments reference the connection buffer, which will be reused as soon as this
+        // call returns, so they are copied for the coroutine.
+        auto buffer = std::make_shared<msgpack::sbuffer>();
+
+        msgpack::packer<msgpack::sbuffer> packer(*buffer);
+
+        packer << unpacked;
+
+        std::make_shared<coroutine_t>(
+            m_reactor,
+            aux::coroutine_body<coroutine_slot>{this->shared_from_this(), buffer, upstream},
+            m_stack_size
+        )->schedule();
+
+        // Return an empty protocol dispatch.
+        return std::shared_ptr<dispatch_t>();
+    }
+
+    void
+    invoke(const msgpack::object& unpacked, const std::shared_ptr<upstream_t>& upstream) const {
+        try {
+            upstream->send<typename protocol::chunk>(this->call(unpacked));
+            upstream->send<typename protocol::choke>();
+        } catch(const std::system_error& e) {
+            upstream->send<typename protocol::error>(e.code().value(), std::string(e.code().message()));
+        } catch(const std::exception& e) {
+            upstream->send<typename protocol::error>(invocation_error, std::string(e.what()));
+        }
+    }
+
+private:
+    reactor_t& m_reactor;
+    const size_t m_stack_size;
+};
+
+// Coroutine slot specialization for void functions
+
+template<class Event>
+struct coroutine_slot<Event, void>:
+    public function_slot<Event, void>,
+    public std::enable_shared_from_this<coroutine_slot<Event, void>>
+{
+    typedef function_slot<Event, void> parent_type;
+
+    typedef typename parent_type::callable_type callable_type;
+    typedef typename parent_type::protocol_type protocol;
+
+    coroutine_slot(reactor_t& reactor, callable_type callable, size_t stack_size = coroutine_t::default_stack_size):
+        parent_type(callable),
+        m_reactor(reactor),
+        m_stack_size(stack_size)
+    { }
+
+    virtual
+    std::shared_ptr<dispatch_t>
+    operator()(const msgpack::object& unpacked, const std::shared_ptr<upstream_t>& upstream) {
+        auto buffer = std::make_shared<msgpack::sbuffer>();
+
+        msgpack::packer<msgpack::sbuffer> packer(*buffer);
+
+        packer << unpacked;
+
+        std::make_shared<coroutine_t>(
+            m_reactor,
+            aux::coroutine_body<coroutine_slot>{this->shared_from_this(), buffer, upstream},
+            m_stack_size
+        )->schedule();
+
+        // Return an empty protocol dispatch.
+        return std::shared_ptr<dispatch_t>();
+    }
+
+    void
+    invoke(const msgpack::object& unpacked, const std::shared_ptr<upstream_t>& upstream) const {
+        try {
+            this->call(unpacked);
+
+            // This is needed anyway so that service clients could detect operation completion.
+            upstream->send<typename protocol::choke>();
+        } catch(const std::system_error& e) {
+            upstream->send<typename protocol::error>(e.code().value(), std::string(e.code().message()));
+        } catch(const std::exception& e) {
+            upstream->send<typename protocol::error>(invocation_error, std::string(e.what()));
+        }
+    }
+
+private:
+    reactor_t& m_reactor;
+    const size_t m_stack_size;
+};
+
+}} // namespace cocaine::io
+
+#endif
@@ -48,18 +48,32 @@ public:
         state(states::active)
     { }
 
+    // Identifies the client connection this upstream belongs to.
+    const session_t*
+    owner() const {
+        return session.get();
+    }
+
     template<class Event, typename... Args>
     void
     send(Args&&... args);
-};
 
-template<class Event, typename... Args>
-void
-upstream_t::send(Args&&... args) {
-    std::lock_guard<std::mutex> guard(session->mutex);
+    // Sends a message with pre-packed arguments, see encoder::write_packed().
+    template<class Event>
+    void
+    send_packed(const char* args, size_t size);
+
+private:
+    template<class Event>
+    bool
+    prepare();
+};
 
+template<class Event>
+bool
+upstream_t::prepare() {
     if(state != states::active) {
-        return;
+        return false;
     }
 
     if(std::is_same<typename io::event_traits<Event>::transition_type, void>::value) {
@@ -71,11 +85,29 @@ upstream_t::send(Args&&... args) {
         session->revoke(index);
     }
 
-    if(session->ptr) {
+    return static_cast<bool>(session->ptr);
+}
+
+template<class Event, typename... Args>
+void
+upstream_t::send(Args&&... args) {
+    std::lock_guard<std::mutex> guard(session->mutex);
+
+    if(prepare<Event>()) {
         session->ptr->wr->write<Event>(index, std::forward<Args>(args)...);
     }
 }
 
+template<class Event>
+void
+upstream_t::send_packed(const char* args, size_t size) {
+    std::lock_guard<std::mutex> guard(session->mutex);
+
+    if(prepare<Event>()) {
+        session->ptr->wr->template write_packed<Event>(index, args, size);
+    }
+}
+
 } // namespace cocaine
 
 #endif
@@ -19,6 +19,7 @@
 */
 
 #include "cocaine/detail/actor.hpp"
+#include "cocaine/detail/affinity.hpp"
 
 #include "cocaine/api/service.hpp"
 
@@ -99,6 +100,23 @@ actor_t::run(std::vector<io::tcp::endpoint> endpoints) {
     m_thread = std::make_unique<boost::thread>(named_runnable{m_prototype->name(), *m_reactor});
 }
 
+void
+actor_t::pin(const std::string& name) {
+    BOOST_ASSERT(m_thread);
+
+    const auto affinity = m_context.config.execution.services.find(name);
+
+    if(affinity == m_context.config.execution.services.end()) {
+        return;
+    }
+
+    const auto error = affinity_t(affinity->second).apply(m_thread->native_handle());
+
+    if(error) {
+        COCAINE_LOG_WARNING(m_log, "unable to bind the service thread to the CPU set - [%d] %s", error.value(), error.message());
+    }
+}
+
 void
 actor_t::terminate() {
     BOOST_ASSERT(m_thread);
@@ -0,0 +1,161 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cocaine/detail/affinity.hpp"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include <boost/lexical_cast.hpp>
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+using namespace cocaine;
+
+namespace {
+
+unsigned
+parse_cpu(const std::string& spec, const std::string& value) {
+    unsigned cpu;
+
+    try {
+        cpu = boost::lexical_cast<unsigned>(value);
+    } catch(const boost::bad_lexical_cast& e) {
+        throw cocaine::error_t("invalid CPU '%s' in the CPU list '%s'", value, spec);
+    }
+
+#if defined(__linux__)
+    if(cpu >= CPU_SETSIZE) {
+        throw cocaine::error_t("CPU %d in the CPU list '%s' is out of range", cpu, spec);
+    }
+#endif
+
+    return cpu;
+}
+
+void
+parse_list(const std::string& spec, std::set<unsigned>& cpus) {
+    std::istringstream stream(spec);
+    std::string range;
+
+    while(std::getline(stream, range, ',')) {
+        // Trailing newlines are there when the list is read from sysfs.
+        range.erase(range.find_last_not_of(" \n") + 1);
+
+        if(range.empty()) {
+            continue;
+        }
+
+        const auto dash = range.find('-');
+
+        if(dash == std::string::npos) {
+            cpus.insert(parse_cpu(spec, range));
+            continue;
+        }
+
+        const unsigned first = parse_cpu(spec, range.substr(0, dash)),
+                       last  = parse_cpu(spec, range.substr(dash + 1));
+
+        if(first > last) {
+            throw cocaine::error_t("invalid CPU range '%s' in the CPU list '%s'", range, spec);
+        }
+
+        for(unsigned cpu = first; cpu <= last; ++cpu) {
+            cpus.insert(cpu);
+        }
+    }
+}
+
+} // namespace
+
+affinity_t::affinity_t(const std::string& spec) {
+    std::set<unsigned> cpus;
+
+    if(spec.compare(0, 5, "node:") == 0) {
+        unsigned node;
+
+        try {
+            node = boost::lexical_cast<unsigned>(spec.substr(5));
+        } catch(const boost::bad_lexical_cast& e) {
+            throw cocaine::error_t("invalid NUMA node in '%s'", spec);
+        }
+
+        std::ifstream stream(cocaine::format("/sys/devices/system/node/node%d/cpulist", node).c_str());
+        std::string list;
+
+        if(!stream || !std::getline(stream, list)) {
+            throw cocaine::error_t("NUMA node %d is not available on this machine", node);
+        }
+
+        parse_list(list, cpus);
+    } else {
+        parse_list(spec, cpus);
+    }
+
+    if(!spec.empty() && cpus.empty()) {
+        throw cocaine::error_t("the CPU set '%s' is empty", spec);
+    }
+
+    m_cpus.assign(cpus.begin(), cpus.end());
+}
+
+affinity_t
+affinity_t::select(size_t index) const {
+    affinity_t result;
+
+    if(!m_cpus.empty()) {
+        result.m_cpus.push_back(m_cpus[index % m_cpus.size()]);
+    }
+
+    return result;
+}
+
+std::error_code
+affinity_t::apply(pthread_t thread) const {
+    if(m_cpus.empty()) {
+        return std::error_code();
+    }
+
+#if defined(__linux__)
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+
+    for(auto it = m_cpus.begin(); it != m_cpus.end(); ++it) {
+        CPU_SET(*it, &set);
+    }
+
+    const int rv = ::pthread_setaffinity_np(thread, sizeof(set), &set);
+
+    if(rv != 0) {
+        return std::error_code(rv, std::system_category());
+    }
+
+    return std::error_code();
+#else
+    (void)thread;
+
+    return std::make_error_code(std::errc::not_supported);
+#endif
+}
@@ -27,6 +27,7 @@
 #include "cocaine/asio/resolver.hpp"
 
 #include "cocaine/detail/actor.hpp"
+#include "cocaine/detail/affinity.hpp"
 #include "cocaine/detail/engine.hpp"
 #include "cocaine/detail/essentials.hpp"
 #include "cocaine/detail/locator.hpp"
@@ -35,11 +36,14 @@
 #include "cocaine/memory.hpp"
 
 #include <cstring>
+#include <unordered_map>
 
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include <boost/lexical_cast.hpp>
+
 #include <netdb.h>
 
 #include "rapidjson/reader.h"
@@ -51,6 +55,11 @@ using namespace std::placeholders;
 
 namespace fs = boost::filesystem;
 
+struct context_t::service_index_t {
+    std::unordered_map<std::string, actor_t*> actors;
+    std::map<std::string, actor_t::metadata_t> metadata;
+};
+
 #include "synchronization.inl"
 
 namespace {
@@ -206,13 +215,27 @@ const float defaults::heartbeat_timeout      = 30.0f;
 const float defaults::idle_timeout           = 600.0f;
 const float defaults::startup_timeout        = 10.0f;
 const float defaults::termination_timeout    = 5.0f;
+const float defaults::report_interval        = 1.0f;
+const float defaults::steal_threshold        = 1.0f;
 const unsigned long defaults::concurrency    = 10L;
 const unsigned long defaults::crashlog_limit = 50L;
 const unsigned long defaults::pool_limit     = 10L;
 const unsigned long defaults::queue_limit    = 100L;
+const unsigned long defaults::worker_queue_limit = 1000L;
+const unsigned long defaults::shared_memory_threshold = 65536L;
+const unsigned long defaults::cache_size     = 64L << 20;
+const unsigned long defaults::cache_body_limit = 64L << 10;
+const float defaults::autoscaling_interval   = 1.0f;
+const float defaults::autoscaling_window     = 10.0f;
+const float defaults::autoscaling_utilization = 0.8f;
+const float defaults::autoscaling_cooldown   = 30.0f;
+const float defaults::shedding_target        = 0.1f;
+const float defaults::shedding_interval      = 1.0f;
+const float defaults::concurrency_tolerance  = 1.5f;
 
 const float defaults::control_timeout        = 5.0f;
 const unsigned defaults::decoder_granularity = 256;
+const float defaults::migration_interval     = 5.0f;
 
 const char defaults::plugins_path[]          = "/usr/lib/cocaine";
 const char defaults::runtime_path[]          = "/var/run/cocaine";
@@ -348,6 +371,42 @@ config_t::config_t(const std::string& config_path) {
         }
     }
 
+    // Execution units
+
+    const auto &execution_config = root.as_object().at("execution", dynamic_t::empty_object).as_object();
+
+    execution.units    = execution_config.at("units", 0UL).to<uint64_t>();
+    execution.affinity = execution_config.at("cpu-affinity", "").as_string();
+    execution.pinned   = execution_config.at("pinned", false).as_bool();
+
+    const auto &services_affinity = execution_config.at("services", dynamic_t::empty_object).as_object();
+
+    for(auto it = services_affinity.begin(); it != services_affinity.end(); ++it) {
+        execution.services[it->first] = it->second.as_string();
+    }
+
+    execution.placement = execution_config.at("placement", "least-connections").as_string();
+    execution.migration_interval = execution_config.at("migration-interval", defaults::migration_interval).to<double>();
+
+    if(execution.placement != "least-connections" &&
+       execution.placement != "least-busy" &&
+       execution.placement != "power-of-two" &&
+       execution.placement != "hash")
+    {
+        throw cocaine::error_t("the connection placement policy '%s' is unknown", execution.placement);
+    }
+
+    // Validate the CPU sets right away, so that the misconfiguration is detected on startup.
+    const affinity_t units_affinity(execution.affinity);
+
+    for(auto it = execution.services.begin(); it != execution.services.end(); ++it) {
+        const affinity_t service_affinity(it->second);
+    }
+
+    if(execution.migration_interval < 0.0f) {
+        throw cocaine::error_t("the connection migration interval must be non-negative");
+    }
+
     // Component configuration
 
     loggers  = root.as_object().at("loggers",  dynamic_t::empty_object).to<config_t::component_map_t>();
@@ -413,6 +472,8 @@ context_t::~context_t() {
     unlocked.front().second->terminate();
     unlocked.pop_front();
 
+    publish(unlocked);
+
     m_synchronization->shutdown();
     m_synchronization.reset();
 
@@ -430,8 +491,12 @@ context_t::~context_t() {
         unlocked.pop_back();
     }
 
+    publish(unlocked);
+
     COCAINE_LOG_INFO(blog, "stopping the execution units");
 
+    std::lock_guard<std::mutex> guard(m_pool_mutex);
+
     m_pool.clear();
 }
 
@@ -479,10 +544,13 @@ context_t::insert(const std::string& name, std::unique_ptr<actor_t>&& service) {
         }};
 
         service->run(endpoints);
+        service->pin(name);
 
         COCAINE_LOG_INFO(blog, "service '%s' published on %d", name, service->location().front());
 
         locked->emplace_back(name, std::move(service));
+
+        publish(*locked);
     }
 
     if(m_synchronization) {
@@ -517,6 +585,8 @@ context_t::remove(const std::string& name) -> std::unique_ptr<actor_t> {
         }
 
         locked->erase(it);
+
+        publish(*locked);
     }
 
     if(m_synchronization) {
@@ -528,23 +598,130 @@ context_t::remove(const std::string& name) -> std::unique_ptr<actor_t> {
 
 auto
 context_t::locate(const std::string& name) const -> boost::optional<actor_t&> {
-    auto locked = m_services.synchronize();
-    auto it = std::find_if(locked->begin(), locked->end(), match{name});
+    const auto index = m_index.load();
 
-    return boost::optional<actor_t&>(it != locked->end(), *it->second);
+    if(!index) {
+        return boost::optional<actor_t&>();
+    }
+
+    auto it = index->actors.find(name);
+
+    if(it == index->actors.end()) {
+        return boost::optional<actor_t&>();
+    }
+
+    return boost::optional<actor_t&>(*it->second);
+}
+
+void
+context_t::publish(const service_list_t& services) {
+    auto index = std::make_shared<service_index_t>();
+
+    for(auto it = services.begin(); it != services.end(); ++it) {
+        index->actors[it->first] = it->second.get();
+        index->metadata[it->first] = it->second->metadata();
+    }
+
+    m_index.store(index);
 }
 
+namespace {
+
+struct fewer_connections {
+    template<class T>
+    bool
+    operator()(const T& lhs, const T& rhs) const {
+        return lhs->connections() < rhs->connections();
+    }
+};
+
+struct less_busy {
+    template<class T>
+    bool
+    operator()(const T& lhs, const T& rhs) const {
+        return lhs->busy_time() < rhs->busy_time() ||
+              (lhs->busy_time() == rhs->busy_time() && lhs->connections() < rhs->connections());
+    }
+};
+
+} // namespace
+
 void
 context_t::attach(const std::shared_ptr<io::socket<io::tcp>>& ptr,
                   const std::shared_ptr<io::dispatch_t>& dispatch)
 {
-    m_pool[ptr->fd() % m_pool.size()]->attach(ptr, dispatch);
+    const std::string& placement = config.execution.placement;
+
+    execution_unit_t* unit;
+
+    if(placement == "hash") {
+        unit = m_pool[ptr->fd() % m_pool.size()].get();
+    } else if(placement == "least-busy") {
+        unit = std::min_element(m_pool.begin(), m_pool.end(), less_busy())->get();
+    } else if(placement == "power-of-two") {
+        size_t lhs, rhs;
+
+        {
+            std::lock_guard<std::mutex> guard(m_random_mutex);
+
+            lhs = m_random() % m_pool.size();
+            rhs = m_random() % m_pool.size();
+        }
+
+        // NOTE: Two random choices are almost as good as the least loaded unit, but don't make all
+        // the concurrent connections pile up on the same unit between the counter updates.
+        unit = fewer_connections()(m_pool[rhs], m_pool[lhs]) ? m_pool[rhs].get() : m_pool[lhs].get();
+    } else {
+        unit = std::min_element(m_pool.begin(), m_pool.end(), fewer_connections())->get();
+    }
+
+    unit->attach(ptr, dispatch);
+}
+
+void
+context_t::rebalance(execution_unit_t& unit) {
+    std::unique_lock<std::mutex> guard(m_pool_mutex, std::try_to_lock);
+
+    // NOTE: The pool is being either grown or destroyed, the migration can wait.
+    if(!guard.owns_lock() || m_pool.empty()) {
+        return;
+    }
+
+    auto& target = **std::min_element(m_pool.begin(), m_pool.end(), fewer_connections());
+
+    const size_t source_load = unit.connections(),
+                 target_load = target.connections();
+
+    // Only move the connections if that makes the units any closer to each other.
+    if(&target == &unit || source_load < target_load + 2) {
+        return;
+    }
+
+    unit.migrate(target, (source_load - target_load) / 2);
+}
+
+auto
+context_t::reports() -> std::map<std::string, std::map<std::string, std::tuple<size_t, size_t>>> {
+    std::map<std::string, std::map<std::string, std::tuple<size_t, size_t>>> result;
+
+    std::lock_guard<std::mutex> guard(m_pool_mutex);
+
+    for(size_t i = 0; i < m_pool.size(); ++i) {
+        result["execution"][boost::lexical_cast<std::string>(i)] = std::make_tuple(
+            m_pool[i]->connections(),
+            m_pool[i]->messages()
+        );
+    }
+
+    return result;
 }
 
 void
 context_t::bootstrap() {
     auto blog = std::make_unique<logging::log_t>(*this, "bootstrap");
-    auto pool = boost::thread::hardware_concurrency() * 2;
+    auto pool = config.execution.units ? config.execution.units : boost::thread::hardware_concurrency() * 2;
+
+    m_random.seed(std::random_device()());
 
     if(config.network.ports) {
         uint16_t min, max;
@@ -560,10 +737,32 @@ context_t::bootstrap() {
 
     COCAINE_LOG_INFO(blog, "growing the execution unit pool to %d units", pool);
 
-    while(pool--) { m_pool.emplace_back(std::make_unique<execution_unit_t>(*this, "cocaine/execute")); }
+    {
+        std::lock_guard<std::mutex> guard(m_pool_mutex);
+
+        const affinity_t affinity(config.execution.affinity);
+
+        for(size_t index = 0; index < pool; ++index) {
+            m_pool.emplace_back(std::make_unique<execution_unit_t>(
+                *this,
+                "cocaine/execute",
+                config.execution.pinned ? affinity.select(index) : affinity
+            ));
+        }
+    }
 
     COCAINE_LOG_INFO(blog, "starting %d %s", config.services.size(), config.services.size() == 1 ? "service" : "services");
 
+    for(auto it = config.execution.services.begin(); it != config.execution.services.end(); ++it) {
+        if(it->first == "locator" || config.services.count(it->first)) {
+            continue;
+        }
+
+        // NOTE: Apps are published under their own names, so such CPU sets might still be used later.
+        COCAINE_LOG_WARNING(blog, "CPU set for '%s' matches no configured service, it will only apply to an app "
+            "with this name", it->first);
+    }
+
     m_synchronization = std::make_shared<synchronization_t>(*this);
 
     for(auto it = config.services.begin(); it != config.services.end(); ++it) {
@@ -572,13 +771,28 @@ context_t::bootstrap() {
         COCAINE_LOG_INFO(blog, "starting service '%s'", it->first);
 
         try {
-            insert(it->first, std::make_unique<actor_t>(*this, reactor, get<api::service_t>(
+            auto service = get<api::service_t>(
                 it->second.type,
                 *this,
                 *reactor,
                 cocaine::format("service/%s", it->first),
                 it->second.args
-            )));
+            );
+
+            // NOTE: Blocking service methods, like storage access, are run on the worker threads if
+            // requested, so that they won't stall all the other connections of the execution unit.
+            const auto workers = it->second.args.as_object().at("workers", 0UL).to<uint64_t>();
+
+            if(workers) {
+                COCAINE_LOG_INFO(blog, "offloading service '%s' blocking methods to %d workers", it->first, workers);
+
+                service->prototype().offload(
+                    workers,
+                    it->second.args.as_object().at("worker-queue-limit", defaults::worker_queue_limit).to<uint64_t>()
+                );
+            }
+
+            insert(it->first, std::make_unique<actor_t>(*this, reactor, std::move(service)));
         } catch(const std::system_error& e) {
             COCAINE_LOG_ERROR(blog, "unable to initialize service '%s' - %s - [%d] %s", it->first, e.what(),
                 e.code().value(), e.code().message());
@@ -608,6 +822,8 @@ context_t::bootstrap() {
         // Some of the locator methods are better implemented in the Context, to avoid unnecessary
         // copying intermediate structures around, for example service lists synchronization.
         locator->on<io::locator::synchronize>(m_synchronization);
+        m_synchronization->start(reactor);
+        locator->on<io::locator::reports>(std::bind(&context_t::reports, this));
 
         service = std::make_unique<actor_t>(
             *this,
@@ -618,6 +834,7 @@ context_t::bootstrap() {
         // NOTE: Start the locator thread last, so that we won't needlessly send node updates to the
         // peers which managed to connect during the bootstrap.
         service->run(endpoints);
+        service->pin("locator");
     } catch(const std::system_error& e) {
         COCAINE_LOG_ERROR(blog, "unable to initialize the locator - %s - [%d] %s", e.what(),
             e.code().value(), e.code().message());
@@ -630,5 +847,9 @@ context_t::bootstrap() {
         throw;
     }
 
-    m_services->emplace_front("locator", std::move(service));
+    auto locked = m_services.synchronize();
+
+    locked->emplace_front("locator", std::move(service));
+
+    publish(*locked);
 }
@@ -0,0 +1,134 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cocaine/detail/coroutine.hpp"
+
+#include "cocaine/asio/reactor.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace cocaine;
+
+namespace {
+
+// NOTE: A plain pointer, as the C++11 thread_local storage is not available in older compilers.
+__thread coroutine_t* current_coroutine = nullptr;
+
+} // namespace
+
+const size_t coroutine_t::default_stack_size = 64 * 1024;
+
+coroutine_t::coroutine_t(io::reactor_t& reactor, const std::function<void()>& body, size_t stack_size):
+    m_reactor(reactor),
+    m_body(body),
+    m_done(false)
+{
+    const size_t page_size = ::sysconf(_SC_PAGESIZE);
+
+    // Round the stack up to whole pages and add the guard page below it, as the stack grows down.
+    m_stack_size = (stack_size + page_size - 1) / page_size * page_size + page_size;
+
+    m_stack = ::mmap(nullptr, m_stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(m_stack == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category(), "unable to allocate the coroutine stack");
+    }
+
+    if(::mprotect(m_stack, page_size, PROT_NONE) != 0 || ::getcontext(&m_callee) != 0) {
+        const int error = errno;
+
+        ::munmap(m_stack, m_stack_size);
+
+        throw std::system_error(error, std::system_category(), "unable to initialize the coroutine context");
+    }
+
+    m_callee.uc_stack.ss_sp   = static_cast<char*>(m_stack) + page_size;
+    m_callee.uc_stack.ss_size = m_stack_size - page_size;
+    m_callee.uc_link          = &m_caller;
+
+    // NOTE: The makecontext() entry point only accepts integer arguments, so the object pointer is
+    // split into two halves to stay portable across 32 and 64-bit platforms.
+    const uint64_t self = reinterpret_cast<uintptr_t>(this);
+
+    ::makecontext(
+        &m_callee,
+        reinterpret_cast<void (*)()>(&coroutine_t::trampoline),
+        2,
+        static_cast<unsigned int>(self >> 32),
+        static_cast<unsigned int>(self & 0xFFFFFFFF)
+    );
+}
+
+coroutine_t::~coroutine_t() {
+    ::munmap(m_stack, m_stack_size);
+}
+
+void
+coroutine_t::resume() {
+    BOOST_ASSERT(!m_done);
+
+    coroutine_t* previous = current_coroutine;
+
+    // Keep the coroutine alive in case its last owner is destroyed while it is running.
+    const std::shared_ptr<coroutine_t> guard = shared_from_this();
+
+    current_coroutine = this;
+
+    ::swapcontext(&m_caller, &m_callee);
+
+    current_coroutine = previous;
+}
+
+void
+coroutine_t::schedule() {
+    m_reactor.post(std::bind(&coroutine_t::resume, shared_from_this()));
+}
+
+void
+coroutine_t::suspend() {
+    BOOST_ASSERT(current_coroutine == this);
+
+    ::swapcontext(&m_callee, &m_caller);
+}
+
+coroutine_t*
+coroutine_t::current() {
+    return current_coroutine;
+}
+
+void
+coroutine_t::trampoline(unsigned int hi, unsigned int lo) {
+    coroutine_t* self = reinterpret_cast<coroutine_t*>(
+        static_cast<uintptr_t>((static_cast<uint64_t>(hi) << 32) | lo)
+    );
+
+    // NOTE: Exceptions can't cross the context boundary, so the body is expected to handle its own
+    // failures, and whatever is left is swallowed here.
+    try {
+        self->m_body();
+    } catch(...) {
+        // Empty.
+    }
+
+    // The uc_link context, i.e. the caller, is resumed once this function returns.
+    self->m_done = true;
+}
@@ -22,6 +22,9 @@
 
 #include "cocaine/context.hpp"
 #include "cocaine/logging.hpp"
+#include "cocaine/memory.hpp"
+
+#include "cocaine/detail/workers.hpp"
 
 #include "cocaine/rpc/message.hpp"
 
@@ -37,6 +40,41 @@ dispatch_t::~dispatch_t() {
     // Empty.
 }
 
+namespace {
+
+struct offloaded_call {
+    void
+    operator()() const {
+        msgpack::zone zone;
+        msgpack::object unpacked;
+
+        size_t offset = 0;
+
+        msgpack::unpack(buffer->data(), buffer->size(), &offset, &zone, &unpacked);
+
+        // NOTE: Blocking slots report their failures to the upstream on their own, so this is only
+        // a safety net. The error message type is the same for all the streaming protocols.
+        try {
+            (*slot)(unpacked, upstream);
+        } catch(const std::exception& e) {
+            upstream->send<io::streaming<void>::error>(static_cast<int>(invocation_error), std::string(e.what()));
+        }
+    }
+
+    const std::shared_ptr<io::detail::slot_concept_t> slot;
+    const std::shared_ptr<msgpack::sbuffer> buffer;
+    const std::shared_ptr<upstream_t> upstream;
+};
+
+} // namespace
+
+void
+dispatch_t::offload(size_t workers, size_t limit) {
+    BOOST_ASSERT(!m_workers);
+
+    m_workers = std::make_unique<worker_pool_t>(m_name, workers, limit);
+}
+
 std::shared_ptr<dispatch_t>
 dispatch_t::invoke(const io::message_t& message, const std::shared_ptr<upstream_t>& upstream) const {
     slot_map_t::const_iterator lb, ub;
@@ -54,6 +92,23 @@ dispatch_t::invoke(const io::message_t& message, const std::shared_ptr<upstream_
 
     COCAINE_LOG_DEBUG(m_log, "processing type %d message using slot '%s'", message.id(), slot->name());
 
+    if(m_workers && slot->blocking()) {
+        // NOTE: The arguments reference the connection buffer, which will be reused as soon as this
+        // call returns, so they are copied for the worker thread.
+        auto buffer = std::make_shared<msgpack::sbuffer>();
+
+        msgpack::packer<msgpack::sbuffer> packer(*buffer);
+
+        packer << message.args();
+
+        if(!m_workers->post(upstream->owner(), offloaded_call{slot, buffer, upstream})) {
+            upstream->send<io::streaming<void>::error>(static_cast<int>(resource_error), std::string("the worker queue is full"));
+        }
+
+        // Blocking slots don't have any protocol transitions.
+        return std::shared_ptr<dispatch_t>();
+    }
+
     try {
         return (*slot)(message.args(), upstream);
     } catch(const std::exception& e) {
@@ -64,6 +119,11 @@ dispatch_t::invoke(const io::message_t& message, const std::shared_ptr<upstream_
     }
 }
 
+auto
+dispatch_t::load() const -> boost::optional<io::locator::synchronize::load_tuple_type> {
+    return boost::none;
+}
+
 std::string
 dispatch_t::name() const {
     return m_name;
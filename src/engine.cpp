@@ -20,11 +20,15 @@
 
 #include "cocaine/detail/engine.hpp"
 
+#include "cocaine/asio/reactor.hpp"
+
 #include "cocaine/context.hpp"
 #include "cocaine/dispatch.hpp"
 #include "cocaine/logging.hpp"
 #include "cocaine/memory.hpp"
 
+#include <chrono>
+
 #if defined(__linux__)
     #include <sys/prctl.h>
 #endif
@@ -51,13 +55,48 @@ struct named_runnable {
     const std::unique_ptr<io::reactor_t>& reactor;
 };
 
+#if defined(__clang__) || defined(HAVE_GCC47)
+    typedef std::chrono::steady_clock clock_type;
+#else
+    typedef std::chrono::monotonic_clock clock_type;
+#endif
+
+// Recent busy time is measured over this many seconds.
+const float sampling_interval = 1.0f;
+
 } // namespace
 
-execution_unit_t::execution_unit_t(context_t& context, const std::string& name):
+execution_unit_t::execution_unit_t(context_t& context, const std::string& name, const affinity_t& affinity):
+    m_context(context),
     m_log(new logging::log_t(context, name)),
+    m_connections(0),
+    m_messages(0),
+    m_busy_time(0),
+    m_recent_busy_time(0),
+    m_busy_mark(0),
     m_reactor(std::make_unique<io::reactor_t>()),
-    m_chamber(std::make_unique<boost::thread>(named_runnable{name, m_reactor}))
-{ }
+    m_sampling_timer(new ev::timer(m_reactor->native())),
+    m_migration_timer(new ev::timer(m_reactor->native()))
+{
+    m_sampling_timer->set<execution_unit_t, &execution_unit_t::on_sample>(this);
+    m_sampling_timer->start(sampling_interval, sampling_interval);
+
+    const float migration_interval = context.config.execution.migration_interval;
+
+    if(migration_interval > 0.0f) {
+        m_migration_timer->set<execution_unit_t, &execution_unit_t::on_migrate>(this);
+        m_migration_timer->start(migration_interval, migration_interval);
+    }
+
+    // NOTE: The thread is started last, as the reactor can't be safely modified once it's running.
+    m_chamber = std::make_unique<boost::thread>(named_runnable{name, m_reactor});
+
+    const auto error = affinity.apply(m_chamber->native_handle());
+
+    if(error) {
+        COCAINE_LOG_WARNING(m_log, "unable to bind the execution unit to the CPU set - [%d] %s", error.value(), error.message());
+    }
+}
 
 execution_unit_t::~execution_unit_t() {
     m_reactor->post(std::bind(&io::reactor_t::stop, m_reactor.get()));
@@ -66,8 +105,10 @@ execution_unit_t::~execution_unit_t() {
     m_chamber.reset();
 
     for(auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
-        // Synchronously close the connections.
-        it->second->detach();
+        if(it->session) {
+            // Synchronously close the connections.
+            it->session->detach();
+        }
     }
 
     m_sessions.clear();
@@ -75,56 +116,100 @@ execution_unit_t::~execution_unit_t() {
 
 void
 execution_unit_t::attach(const std::shared_ptr<io::socket<io::tcp>>& socket, const std::shared_ptr<io::dispatch_t>& dispatch) {
+    // NOTE: The connection is accounted right away, so that a burst of new connections won't pick
+    // the same unit before the first one of them gets actually connected.
+    m_connections++;
+
     m_reactor->post(std::bind(&execution_unit_t::on_connect, this, socket, dispatch));
 }
 
+size_t
+execution_unit_t::migrate(execution_unit_t& target, size_t count) {
+    size_t migrated = 0;
+
+    for(auto it = m_sessions.begin(); it != m_sessions.end() && migrated < count; ++it) {
+        if(!it->session) {
+            continue;
+        }
+
+        const auto socket = it->session->release();
+
+        if(!socket) {
+            continue;
+        }
+
+        target.attach(socket, it->session->dispatch());
+
+        it->session.reset();
+        it->generation++;
+
+        m_connections--;
+
+        migrated++;
+    }
+
+    if(migrated) {
+        COCAINE_LOG_DEBUG(m_log, "migrated %llu idle %s", migrated, migrated == 1 ? "connection" : "connections");
+    }
+
+    return migrated;
+}
+
 void
 execution_unit_t::on_connect(const std::shared_ptr<io::socket<io::tcp>>& socket, const std::shared_ptr<io::dispatch_t>& dispatch) {
     auto fd = socket->fd();
 
-    BOOST_ASSERT(!m_sessions.count(fd));
+    if(static_cast<size_t>(fd) >= m_sessions.size()) {
+        m_sessions.resize(fd + 1);
+    }
+
+    slot_t& slot = m_sessions[fd];
+
+    BOOST_ASSERT(!slot.session);
 
     auto ptr = std::make_unique<io::channel<io::socket<io::tcp>>>(*m_reactor, socket);
 
     using namespace std::placeholders;
 
     ptr->rd->bind(
-        std::bind(&execution_unit_t::on_message, this, fd, _1),
-        std::bind(&execution_unit_t::on_failure, this, fd, _1)
+        std::bind(&execution_unit_t::on_message, this, fd, slot.generation, _1),
+        std::bind(&execution_unit_t::on_failure, this, fd, slot.generation, _1)
     );
 
     ptr->wr->bind(
-        std::bind(&execution_unit_t::on_failure, this, fd, _1)
+        std::bind(&execution_unit_t::on_failure, this, fd, slot.generation, _1)
     );
 
-    m_sessions[fd] = std::make_shared<session_t>(std::move(ptr), dispatch);
+    slot.session = std::make_shared<session_t>(std::move(ptr), dispatch);
 }
 
 void
-execution_unit_t::on_message(int fd, const io::message_t& message) {
-    auto it = m_sessions.find(fd);
+execution_unit_t::on_message(int fd, uint64_t generation, const io::message_t& message) {
+    const slot_t& slot = m_sessions[fd];
+
+    if(slot.generation != generation) {
+        // The connection has been dropped while some of its messages were still being decoded.
+        return;
+    }
 
-    BOOST_ASSERT(it != m_sessions.end());
+    const auto start = clock_type::now();
 
     try {
-        it->second->invoke(message);
+        slot.session->invoke(message);
     } catch(const std::exception& e) {
         COCAINE_LOG_ERROR(m_log, "client on fd %d has disconnected - %s", fd, e.what());
-
-        // NOTE: This destroys the connection but not necessarily the session itself, as it might be
-        // still in use by shared upstreams even in other threads. In other words, this doesn't guarantee
-        // that the session will be actually deleted, but it's fine, since the connection is closed.
-        it->second->detach();
-        m_sessions.erase(it);
+        remove(fd);
     }
+
+    m_messages++;
+    m_busy_time += std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - start).count();
 }
 
 void
-execution_unit_t::on_failure(int fd, const std::error_code& error) {
-    if(!m_sessions.count(fd)) {
-        // TODO: COCAINE-75 fixes this via cancellation.
-        // Check whether the connection actually exists, in case multiple errors were queued up in
-        // the reactor and it was already dropped.
+execution_unit_t::on_failure(int fd, uint64_t generation, const std::error_code& error) {
+    if(m_sessions[fd].generation != generation) {
+        // Multiple errors might be queued up in the reactor, and the connection has already been
+        // dropped by the first one, and maybe even replaced with a new one with the same fd.
         return;
     } else if(error) {
         COCAINE_LOG_ERROR(m_log, "client on fd %d has disconnected - [%d] %s", fd, error.value(), error.message());
@@ -132,6 +217,32 @@ execution_unit_t::on_failure(int fd, const std::error_code& error) {
         COCAINE_LOG_DEBUG(m_log, "client on fd %d has disconnected", fd);
     }
 
-    m_sessions[fd]->detach();
-    m_sessions.erase(fd);
+    remove(fd);
+}
+
+void
+execution_unit_t::remove(int fd) {
+    slot_t& slot = m_sessions[fd];
+
+    // NOTE: This destroys the connection but not necessarily the session itself, as it might be
+    // still in use by shared upstreams even in other threads. In other words, this doesn't guarantee
+    // that the session will be actually deleted, but it's fine, since the connection is closed.
+    slot.session->detach();
+    slot.session.reset();
+    slot.generation++;
+
+    m_connections--;
+}
+
+void
+execution_unit_t::on_sample(ev::timer&, int) {
+    const uint64_t busy_time = m_busy_time.load(std::memory_order_relaxed);
+
+    m_recent_busy_time.store(busy_time - m_busy_mark, std::memory_order_relaxed);
+    m_busy_mark = busy_time;
+}
+
+void
+execution_unit_t::on_migrate(ev::timer&, int) {
+    m_context.rebalance(*this);
 }
@@ -19,6 +19,7 @@
 */
 
 #include "cocaine/detail/isolates/process.hpp"
+#include "cocaine/detail/isolates/zygote.hpp"
 #include "cocaine/detail/gateways/adhoc.hpp"
 #include "cocaine/detail/loggers/files.hpp"
 #include "cocaine/detail/loggers/syslog.hpp"
@@ -32,6 +33,7 @@
 void
 cocaine::essentials::initialize(api::repository_t& repository) {
     repository.insert<isolate::process_t>("process");
+    repository.insert<isolate::zygote_t>("zygote");
     repository.insert<gateway::adhoc_t>("adhoc");
     repository.insert<logger::files_t>("files");
     repository.insert<logger::syslog_t>("syslog");
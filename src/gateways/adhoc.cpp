@@ -31,6 +31,24 @@ adhoc_t::adhoc_t(context_t& context, const std::string& name, const dynamic_t& a
     category_type(context, name, args),
     m_log(new logging::log_t(context, name))
 {
+    const auto balancing = args.as_object().at("balancing", "random").as_string();
+
+    if(balancing != "random" && balancing != "power-of-two") {
+        throw cocaine::error_t("the balancing policy must be either 'random' or 'power-of-two'");
+    }
+
+    m_power_of_two = balancing == "power-of-two";
+
+    const double staleness = args.as_object().at("staleness", 15.0).to<double>();
+
+    if(staleness <= 0.0) {
+        throw cocaine::error_t("the load metrics staleness limit must be positive");
+    }
+
+    m_staleness = std::chrono::duration_cast<clock_type::duration>(
+        std::chrono::duration<double>(staleness)
+    );
+
 #if defined(__clang__) || defined(HAVE_GCC46)
     std::random_device device;
     m_random_generator.seed(device());
@@ -45,6 +63,8 @@ adhoc_t::~adhoc_t() {
 
 auto
 adhoc_t::resolve(const std::string& name) const -> metadata_t {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
     auto lb = m_remote_services.end(),
          ub = lb;
 
@@ -54,13 +74,34 @@ adhoc_t::resolve(const std::string& name) const -> metadata_t {
         throw cocaine::error_t("the specified service is not available in the group");
     }
 
+    const int count = std::distance(lb, ub);
+
 #if defined(__clang__) || defined(HAVE_GCC46)
-    std::uniform_int_distribution<int> distribution(0, std::distance(lb, ub) - 1);
+    std::uniform_int_distribution<int> distribution(0, count - 1);
 #else
-    std::uniform_int<int> distribution(0, std::distance(lb, ub) - 1);
+    std::uniform_int<int> distribution(0, count - 1);
 #endif
 
-    std::advance(lb, distribution(m_random_generator));
+    auto it = lb;
+
+    std::advance(it, distribution(m_random_generator));
+
+    if(m_power_of_two && count > 1) {
+#if defined(__clang__) || defined(HAVE_GCC46)
+        std::uniform_int_distribution<int> offset(1, count - 1);
+#else
+        std::uniform_int<int> offset(1, count - 1);
+#endif
+
+        auto other = lb;
+
+        // Pick the second node out of the remaining ones, so that the two choices always differ.
+        std::advance(other, (std::distance(lb, it) + offset(m_random_generator)) % count);
+
+        it = select(it, other);
+    }
+
+    lb = it;
 
     const auto endpoint = std::get<0>(lb->second.meta);
 
@@ -80,9 +121,11 @@ void
 adhoc_t::consume(const std::string& uuid, const std::string& name, const metadata_t& meta) {
     COCAINE_LOG_DEBUG(m_log, "consumed node '%s' service '%s'", uuid, name);
 
+    std::lock_guard<std::mutex> guard(m_mutex);
+
     m_remote_services.insert({
         name,
-        remote_service_t { uuid, meta }
+        remote_service_t { uuid, meta, load_t(), clock_type::time_point() }
     });
 }
 
@@ -90,6 +133,8 @@ void
 adhoc_t::cleanup(const std::string& uuid, const std::string& name) {
     COCAINE_LOG_DEBUG(m_log, "removing node '%s' service '%s'", uuid, name);
 
+    std::lock_guard<std::mutex> guard(m_mutex);
+
     remote_service_map_t::iterator it, end;
 
     std::tie(it, end) = m_remote_services.equal_range(name);
@@ -102,3 +147,47 @@ adhoc_t::cleanup(const std::string& uuid, const std::string& name) {
         }
     }
 }
+
+void
+adhoc_t::update(const std::string& uuid, const std::map<std::string, load_t>& load) {
+    const auto now = clock_type::now();
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    for(auto it = load.begin(); it != load.end(); ++it) {
+        remote_service_map_t::iterator service, end;
+
+        std::tie(service, end) = m_remote_services.equal_range(it->first);
+
+        for(; service != end; ++service) {
+            if(service->second.uuid == uuid) {
+                service->second.load = it->second;
+                service->second.updated = now;
+            }
+        }
+    }
+}
+
+auto
+adhoc_t::select(remote_service_map_t::const_iterator lhs, remote_service_map_t::const_iterator rhs) const
+    -> remote_service_map_t::const_iterator
+{
+    const auto now = clock_type::now();
+
+    // NOTE: Stale metrics say nothing about the current node load, so it's better to fall back to
+    // the random choice, which has already been made.
+    if(now - lhs->second.updated > m_staleness || now - rhs->second.updated > m_staleness) {
+        return lhs;
+    }
+
+    uint64_t lhs_depth, lhs_active, rhs_depth, rhs_active;
+
+    std::tie(lhs_depth, lhs_active) = lhs->second.load;
+    std::tie(rhs_depth, rhs_active) = rhs->second.load;
+
+    // Compare the queue depths per active slave, without the division.
+    const uint64_t lhs_score = lhs_depth * std::max<uint64_t>(rhs_active, 1),
+                   rhs_score = rhs_depth * std::max<uint64_t>(lhs_active, 1);
+
+    return rhs_score < lhs_score ? rhs : lhs;
+}
@@ -29,7 +29,6 @@
 #include <csignal>
 #include <cstdlib>
 #include <cstring>
-#include <iostream>
 #include <system_error>
 
 #include <boost/filesystem/operations.hpp>
@@ -39,6 +38,7 @@
 #endif
 
 #include <fcntl.h>
+#include <spawn.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -47,6 +47,14 @@
 #include <libcgroup.h>
 #endif
 
+// NOTE: Changing the working directory of a spawned process is a glibc extension which is there
+// since glibc 2.29, otherwise the slaves are started the old way via fork() and execve(). The same
+// goes for the apps with cgroup controllers configured, because such slaves must be attached to
+// their cgroup before they start executing.
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+    #define COCAINE_PROCESS_POSIX_SPAWN
+#endif
+
 using namespace cocaine;
 using namespace cocaine::isolate;
 
@@ -90,6 +98,31 @@ private:
     const int m_stdout;
 };
 
+// Reports a child initialization failure before the exec. Only async-signal-safe calls are allowed
+// there, so the message is formatted in the parent beforehand and the error code is printed by hand.
+void
+report(const std::string& message, int code) {
+    char buffer[32];
+    char* ptr = buffer + sizeof(buffer);
+
+    *--ptr = '\n';
+    *--ptr = ']';
+
+    do {
+        *--ptr = '0' + code % 10;
+    } while(code /= 10);
+
+    *--ptr = '[';
+    *--ptr = ' ';
+    *--ptr = '-';
+    *--ptr = ' ';
+
+    ssize_t rv = ::write(STDERR_FILENO, message.data(), message.size());
+    rv = ::write(STDERR_FILENO, ptr, buffer + sizeof(buffer) - ptr);
+
+    (void)rv;
+}
+
 #ifdef COCAINE_ALLOW_CGROUPS
 struct cgroup_configurator_t:
     public boost::static_visitor<>
@@ -147,6 +180,20 @@ process_t::process_t(context_t& context, const std::string& name, const dynamic_
     m_working_directory(fs::path(args.as_object().at("spool", "/var/spool/cocaine").as_string()) / name)
 {
 #ifdef COCAINE_ALLOW_CGROUPS
+    m_cgroup = nullptr;
+
+    bool configured = false;
+
+    for(auto c = args.as_object().begin(); c != args.as_object().end(); ++c) {
+        configured = configured || (c->second.is_object() && !c->second.as_object().empty());
+    }
+
+    // NOTE: Without any controllers configured, there's no cgroup to attach the slaves to, so they
+    // are spawned without forking the daemon.
+    if(!configured) {
+        return;
+    }
+
     int rv = 0;
 
     if((rv = cgroup_init()) != 0) {
@@ -187,6 +234,10 @@ process_t::process_t(context_t& context, const std::string& name, const dynamic_
 
 process_t::~process_t() {
 #ifdef COCAINE_ALLOW_CGROUPS
+    if(!m_cgroup) {
+        return;
+    }
+
     int rv = 0;
 
     if((rv = cgroup_delete_cgroup(m_cgroup, false)) != 0) {
@@ -208,8 +259,75 @@ process_t::~process_t() {
     extern char** environ;
 #endif
 
+void
+process_t::prepare(const api::string_map_t& environment) {
+    if(!m_envp.empty() && environment == m_environment) {
+        return;
+    }
+
+    m_environment = environment;
+    m_envp_storage.clear();
+    m_envp.clear();
+
+    for(char** ptr = environ; *ptr != nullptr; ++ptr) {
+        m_envp_storage.emplace_back(*ptr);
+    }
+
+    for(auto it = environment.begin(); it != environment.end(); ++it) {
+        m_envp_storage.push_back(it->first + "=" + it->second);
+    }
+
+    for(auto it = m_envp_storage.begin(); it != m_envp_storage.end(); ++it) {
+        m_envp.push_back(const_cast<char*>(it->c_str()));
+    }
+
+    m_envp.push_back(nullptr);
+}
+
+const int process_t::inherited_descriptor;
+
 std::unique_ptr<api::handle_t>
 process_t::spawn(const std::string& path, const api::string_map_t& args, const api::string_map_t& environment) {
+    return spawn(path, args, environment, -1);
+}
+
+std::unique_ptr<api::handle_t>
+process_t::spawn(const std::string& path, const api::string_map_t& args, const api::string_map_t& environment,
+                 int descriptor)
+{
+    // Prepare the command line and the environment
+
+    auto target = fs::path(path);
+
+#if BOOST_VERSION >= 104600
+    if(!target.is_absolute()) {
+#else
+    if(!target.is_complete()) {
+#endif
+        target = m_working_directory / target;
+    }
+
+#if BOOST_VERSION >= 104600
+    const std::string executable = target.native();
+#else
+    const std::string executable = target.string();
+#endif
+
+    std::vector<char*> argv = { const_cast<char*>(executable.c_str()) };
+
+    for(auto it = args.begin(); it != args.end(); ++it) {
+        argv.push_back(const_cast<char*>(it->first.c_str()));
+        argv.push_back(const_cast<char*>(it->second.c_str()));
+    }
+
+    argv.push_back(nullptr);
+
+    // NOTE: The environment block stays the same for every slave of the app, so it is built once
+    // and reused for subsequent spawns. The lock also keeps it intact until the spawn is complete.
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    prepare(environment);
+
     std::array<int, 2> pipes;
 
     if(::pipe(pipes.data()) != 0) {
@@ -220,82 +338,210 @@ process_t::spawn(const std::string& path, const api::string_map_t& args, const a
         ::fcntl(*it, F_SETFD, FD_CLOEXEC);
     }
 
-    const pid_t pid = ::fork();
+    pid_t pid = 0;
 
-    if(pid < 0) {
+    try {
+#if defined(COCAINE_PROCESS_POSIX_SPAWN) && defined(COCAINE_ALLOW_CGROUPS)
+        if(!m_cgroup) {
+            pid = spawn_posix(path, argv, pipes[1], descriptor);
+        } else {
+            pid = spawn_forked(path, argv, pipes[1], descriptor);
+        }
+#elif defined(COCAINE_PROCESS_POSIX_SPAWN)
+        pid = spawn_posix(path, argv, pipes[1], descriptor);
+#else
+        pid = spawn_forked(path, argv, pipes[1], descriptor);
+#endif
+    } catch(...) {
         std::for_each(pipes.begin(), pipes.end(), ::close);
-        throw std::system_error(errno, std::system_category(), "unable to fork");
+        throw;
     }
 
-    ::close(pipes[pid > 0]);
+    ::close(pipes[1]);
 
-    if(pid > 0) {
-        return std::make_unique<process_handle_t>(pid, pipes[0]);
+    return std::make_unique<process_handle_t>(pid, pipes[0]);
+}
+
+#ifdef COCAINE_PROCESS_POSIX_SPAWN
+pid_t
+process_t::spawn_posix(const std::string& path, std::vector<char*>& argv, int output, int descriptor) {
+    // NOTE: The libc implementation of posix_spawn() doesn't copy the parent's page tables, so the
+    // spawn time doesn't depend on the daemon's memory footprint, and it takes care of the signal
+    // handlers in the child, which makes it safe to use in a multithreaded process. All the signal
+    // dispositions are reset to their defaults and all the signals are unblocked in the slave.
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attributes;
+
+    // NOTE: Duplicating a descriptor onto itself doesn't reset its close-on-exec flag, so in this
+    // case it is duplicated via some other descriptor number first.
+    int inherited = descriptor;
+
+    if(descriptor == inherited_descriptor) {
+        inherited = ::fcntl(descriptor, F_DUPFD_CLOEXEC, inherited_descriptor + 1);
+
+        if(inherited == -1) {
+            throw std::system_error(errno, std::system_category(), "unable to duplicate the inherited descriptor");
+        }
     }
 
-    // Child initialization
+    ::posix_spawn_file_actions_init(&actions);
+    ::posix_spawn_file_actions_adddup2(&actions, output, STDOUT_FILENO);
+    ::posix_spawn_file_actions_adddup2(&actions, output, STDERR_FILENO);
+    ::posix_spawn_file_actions_addchdir_np(&actions, m_working_directory.c_str());
 
-    ::dup2(pipes[1], STDOUT_FILENO);
-    ::dup2(pipes[1], STDERR_FILENO);
+    if(inherited != -1) {
+        ::posix_spawn_file_actions_adddup2(&actions, inherited, inherited_descriptor);
+    }
 
-#ifdef COCAINE_ALLOW_CGROUPS
-    // Attach to the control group
+    sigset_t signals, defaults;
 
-    int rv = 0;
+    sigemptyset(&signals);
+    sigfillset(&defaults);
 
-    if((rv = cgroup_attach_task(m_cgroup)) != 0) {
-        std::cerr << cocaine::format("unable to attach the process to a cgroup - %s", cgroup_strerror(rv));
-        std::_Exit(EXIT_FAILURE);
+    ::posix_spawnattr_init(&attributes);
+    ::posix_spawnattr_setsigmask(&attributes, &signals);
+    ::posix_spawnattr_setsigdefault(&attributes, &defaults);
+    ::posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    pid_t pid = 0;
+
+    const int rv = ::posix_spawn(&pid, argv[0], &actions, &attributes, argv.data(), m_envp.data());
+
+    ::posix_spawnattr_destroy(&attributes);
+    ::posix_spawn_file_actions_destroy(&actions);
+
+    if(inherited != descriptor) {
+        ::close(inherited);
+    }
+
+    if(rv != 0) {
+        throw std::system_error(rv, std::system_category(), cocaine::format("unable to spawn '%s'", path));
     }
+
+    return pid;
+}
 #endif
 
-    // Set the correct working directory
+pid_t
+process_t::spawn_forked(const std::string& path, std::vector<char*>& argv, int output, int descriptor) {
+    // NOTE: Only async-signal-safe calls are allowed in the child, so everything it might need is
+    // prepared here, including the failure messages.
+    const std::string chdir_failure = cocaine::format(
+        "unable to change the working directory to '%s'",
+        m_working_directory.string()
+    );
 
-    try {
-        fs::current_path(m_working_directory);
-    } catch(const fs::filesystem_error& e) {
-        std::cerr << cocaine::format("unable to change the working directory to '%s' - %s", m_working_directory, e.what());
-        std::_Exit(EXIT_FAILURE);
-    }
+    const std::string exec_failure = cocaine::format("unable to execute '%s'", path);
 
-    // Prepare the command line and the environment
+    // The child waits on this pipe until it is attached to the control group by the parent. It
+    // exits if the pipe is closed without a go-ahead byte.
+    std::array<int, 2> gate = {{ -1, -1 }};
 
-    auto target = fs::path(path);
+#ifdef COCAINE_ALLOW_CGROUPS
+    if(m_cgroup) {
+        if(::pipe(gate.data()) != 0) {
+            throw std::system_error(errno, std::system_category(), "unable to create a cgroup gate pipe");
+        }
 
-#if BOOST_VERSION >= 104600
-    if(!target.is_absolute()) {
-#else
-    if(!target.is_complete()) {
+        for(auto it = gate.begin(); it != gate.end(); ++it) {
+            ::fcntl(*it, F_SETFD, FD_CLOEXEC);
+        }
+    }
 #endif
-        target = m_working_directory / target;
+
+    const pid_t pid = ::fork();
+
+    if(pid < 0) {
+        const std::error_code ec(errno, std::system_category());
+
+        if(gate[0] != -1) {
+            std::for_each(gate.begin(), gate.end(), ::close);
+        }
+
+        throw std::system_error(ec, "unable to fork");
     }
 
-#if BOOST_VERSION >= 104600
-    std::vector<char*> argv = { ::strdup(target.native().c_str()) }, envp;
-#else
-    std::vector<char*> argv = { ::strdup(target.string().c_str()) }, envp;
+    if(pid > 0) {
+#ifdef COCAINE_ALLOW_CGROUPS
+        if(m_cgroup) {
+            ::close(gate[0]);
+
+            // Attach to the control group
+
+            int rv = 0;
+
+            if((rv = cgroup_attach_task_pid(m_cgroup, pid)) != 0) {
+                ::close(gate[1]);
+
+                ::kill(pid, SIGKILL);
+                ::waitpid(pid, nullptr, 0);
+
+                throw cocaine::error_t("unable to attach the process to a cgroup - %s", cgroup_strerror(rv));
+            }
+
+            const char go = 0;
+
+            if(::write(gate[1], &go, sizeof(go)) != sizeof(go)) {
+                const std::error_code ec(errno, std::system_category());
+
+                ::close(gate[1]);
+
+                ::kill(pid, SIGKILL);
+                ::waitpid(pid, nullptr, 0);
+
+                throw std::system_error(ec, "unable to start the process");
+            }
+
+            ::close(gate[1]);
+        }
 #endif
 
-    for(auto it = args.begin(); it != args.end(); ++it) {
-        argv.push_back(::strdup(it->first.c_str()));
-        argv.push_back(::strdup(it->second.c_str()));
+        return pid;
     }
 
-    argv.push_back(nullptr);
+    // Child initialization
 
-    for(char** ptr = environ; *ptr != nullptr; ++ptr) {
-        envp.push_back(::strdup(*ptr));
+    ::dup2(output, STDOUT_FILENO);
+    ::dup2(output, STDERR_FILENO);
+
+    if(gate[0] != -1) {
+        // Wait until the parent attaches this process to the control group
+
+        ::close(gate[1]);
+
+        char go = 0;
+        ssize_t length = 0;
+
+        while((length = ::read(gate[0], &go, sizeof(go))) < 0 && errno == EINTR) {
+            // Retry.
+        }
+
+        if(length != sizeof(go)) {
+            std::_Exit(EXIT_FAILURE);
+        }
     }
 
-    boost::format format("%s=%s");
+    // Pass the inherited descriptor
 
-    for(auto it = environment.begin(); it != environment.end(); ++it, format.clear()) {
-        envp.push_back(::strdup((format % it->first % it->second).str().c_str()));
+    if(descriptor == inherited_descriptor) {
+        ::fcntl(descriptor, F_SETFD, 0);
+    } else if(descriptor != -1) {
+        ::dup2(descriptor, inherited_descriptor);
     }
 
-    envp.push_back(nullptr);
+    // Set the correct working directory
+
+    if(::chdir(m_working_directory.c_str()) != 0) {
+        report(chdir_failure, errno);
+        std::_Exit(EXIT_FAILURE);
+    }
 
-    // Unblock all the signals
+    // Reset the signal dispositions and unblock all the signals
+
+    for(int signal = 1; signal < NSIG; ++signal) {
+        ::signal(signal, SIG_DFL);
+    }
 
     sigset_t signals;
 
@@ -305,10 +551,9 @@ process_t::spawn(const std::string& path, const api::string_map_t& args, const a
 
     // Spawn the slave
 
-    if(::execve(argv[0], argv.data(), envp.data()) != 0) {
-        std::error_code ec(errno, std::system_category());
-        std::cerr << cocaine::format("unable to execute '%s' - [%d] %s", path, ec.value(), ec.message());
-    }
+    ::execve(argv[0], argv.data(), m_envp.data());
+
+    report(exec_failure, errno);
 
     std::_Exit(EXIT_FAILURE);
 }
@@ -0,0 +1,355 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cocaine/detail/isolates/zygote.hpp"
+#include "cocaine/detail/isolates/process.hpp"
+
+#include "cocaine/context.hpp"
+#include "cocaine/logging.hpp"
+#include "cocaine/memory.hpp"
+#include "cocaine/traits.hpp"
+
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+#include <system_error>
+
+#include <boost/lexical_cast.hpp>
+
+#define BOOST_BIND_NO_PLACEHOLDERS
+#include <boost/thread/thread.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifndef MSG_CMSG_CLOEXEC
+    #define MSG_CMSG_CLOEXEC 0
+#endif
+
+#ifndef MSG_NOSIGNAL
+    #define MSG_NOSIGNAL 0
+#endif
+
+using namespace cocaine;
+using namespace cocaine::isolate;
+
+namespace {
+
+struct zygote_handle_t:
+    public api::handle_t
+{
+    zygote_handle_t(pid_t pid, int stdout):
+        m_pid(pid),
+        m_stdout(stdout)
+    { }
+
+    virtual
+   ~zygote_handle_t() {
+        terminate();
+    }
+
+    virtual
+    void
+    terminate() {
+        // NOTE: Workers are children of the zygote, so it's the zygote who reaps them, and the pid
+        // might have been reused already. The worker holds the write end of its output pipe while
+        // it's alive, so it's only signalled if the pipe hasn't been hung up yet.
+        if(m_stdout != -1) {
+            struct pollfd fd = { m_stdout, 0, 0 };
+
+            if(::poll(&fd, 1, 0) == 0 || !(fd.revents & (POLLHUP | POLLERR | POLLNVAL))) {
+                ::kill(m_pid, SIGTERM);
+            }
+
+            ::close(m_stdout);
+        }
+
+        m_stdout = -1;
+    }
+
+    virtual
+    int
+    stdout() const {
+        return m_stdout;
+    }
+
+private:
+    const pid_t m_pid;
+    int m_stdout;
+};
+
+} // namespace
+
+struct zygote_t::drainer_t {
+    COCAINE_DECLARE_NONCOPYABLE(drainer_t)
+
+    drainer_t(logging::log_t& log, int output):
+        m_log(log),
+        m_output(output)
+    {
+        if(::pipe(m_stop.data()) != 0) {
+            throw std::system_error(errno, std::system_category(), "unable to create a drainer pipe");
+        }
+
+        for(auto it = m_stop.begin(); it != m_stop.end(); ++it) {
+            ::fcntl(*it, F_SETFD, FD_CLOEXEC);
+        }
+
+        m_thread.reset(new boost::thread(&drainer_t::run, this));
+    }
+
+   ~drainer_t() {
+        // NOTE: Closing the write end wakes up the thread.
+        ::close(m_stop[1]);
+
+        m_thread->join();
+
+        ::close(m_stop[0]);
+    }
+
+private:
+    void
+    run() {
+        std::array<char, 4096> buffer;
+
+        struct pollfd fds[] = {
+            { m_output,  POLLIN, 0 },
+            { m_stop[0], POLLIN, 0 }
+        };
+
+        while(true) {
+            if(::poll(fds, 2, -1) < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+
+                return;
+            }
+
+            if(fds[1].revents) {
+                return;
+            }
+
+            const ssize_t length = ::read(m_output, buffer.data(), buffer.size());
+
+            if(length > 0) {
+                COCAINE_LOG_DEBUG((&m_log), "zygote output: %s", std::string(buffer.data(), length));
+            } else if(length == 0 || (errno != EAGAIN && errno != EINTR)) {
+                // The zygote has exited, there's nothing to drain anymore.
+                return;
+            }
+        }
+    }
+
+private:
+    logging::log_t& m_log;
+
+    const int m_output;
+
+    std::array<int, 2> m_stop;
+    std::unique_ptr<boost::thread> m_thread;
+};
+
+zygote_t::zygote_t(context_t& context, const std::string& name, const dynamic_t& args):
+    category_type(context, name, args),
+    m_context(context),
+    m_log(new logging::log_t(context, name)),
+    m_timeout(args.as_object().at("timeout", 5.0f).to<double>()),
+    m_process(new process_t(context, name, args)),
+    m_control(-1)
+{ }
+
+zygote_t::~zygote_t() {
+    reset();
+}
+
+void
+zygote_t::spool() {
+    m_process->spool();
+}
+
+std::unique_ptr<api::handle_t>
+zygote_t::spawn(const std::string& path, const api::string_map_t& args, const api::string_map_t& environment) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if(m_control != -1 && environment != m_environment) {
+        COCAINE_LOG_INFO(m_log, "environment has changed, relaunching the zygote");
+        reset();
+    }
+
+    // NOTE: If the zygote has died since the last request, it is relaunched and the request is
+    // retried once. A zygote failing right after the launch means that the app is broken.
+    for(int attempt = 0;; ++attempt) {
+        if(m_control == -1) {
+            launch(path, args, environment);
+        }
+
+        try {
+            return fork(args);
+        } catch(const std::system_error& e) {
+            reset();
+
+            if(attempt) {
+                throw;
+            }
+
+            COCAINE_LOG_WARNING(
+                m_log,
+                "zygote has failed to fork a worker, relaunching - [%d] %s",
+                e.code().value(),
+                e.code().message()
+            );
+        }
+    }
+}
+
+void
+zygote_t::launch(const std::string& path, const api::string_map_t& args, const api::string_map_t& environment) {
+    std::array<int, 2> sockets;
+
+    // NOTE: Sequenced packets preserve the message boundaries, so no extra framing is needed. Both
+    // ends are closed on exec, so that they don't leak into the processes spawned concurrently, the
+    // zygote gets its end as the inherited descriptor.
+    if(::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets.data()) != 0) {
+        throw std::system_error(errno, std::system_category(), "unable to create a control socket");
+    }
+
+    api::string_map_t zygote_args(args);
+
+    zygote_args["--zygote"] = boost::lexical_cast<std::string>(process_t::inherited_descriptor);
+
+    try {
+        m_zygote = m_process->spawn(path, zygote_args, environment, sockets[1]);
+    } catch(...) {
+        std::for_each(sockets.begin(), sockets.end(), ::close);
+        throw;
+    }
+
+    ::close(sockets[1]);
+
+    m_control = sockets[0];
+
+    struct timeval timeout = {
+        static_cast<time_t>(m_timeout),
+        static_cast<suseconds_t>((m_timeout - static_cast<time_t>(m_timeout)) * 1000000)
+    };
+
+    ::setsockopt(m_control, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(m_control, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    m_environment = environment;
+
+    ::fcntl(m_zygote->stdout(), F_SETFL, O_NONBLOCK);
+
+    m_drainer.reset(new drainer_t(*m_log, m_zygote->stdout()));
+
+    COCAINE_LOG_INFO(m_log, "zygote has been launched for '%s'", path);
+}
+
+std::unique_ptr<api::handle_t>
+zygote_t::fork(const api::string_map_t& args) {
+    std::ostringstream buffer;
+    msgpack::packer<std::ostringstream> packer(buffer);
+
+    io::type_traits<api::string_map_t>::pack(packer, args);
+
+    const std::string request = buffer.str();
+
+    if(::send(m_control, request.data(), request.size(), MSG_NOSIGNAL) < 0) {
+        throw std::system_error(errno, std::system_category(), "unable to send a spawn request");
+    }
+
+    char response[64];
+
+    struct iovec io = { response, sizeof(response) };
+
+    union {
+        struct cmsghdr header;
+        char data[CMSG_SPACE(sizeof(int))];
+    } control;
+
+    struct msghdr message;
+
+    std::memset(&message, 0, sizeof(message));
+
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data;
+    message.msg_controllen = sizeof(control.data);
+
+    const ssize_t length = ::recvmsg(m_control, &message, MSG_CMSG_CLOEXEC);
+
+    if(length < 0) {
+        throw std::system_error(errno, std::system_category(), "unable to receive a spawn response");
+    } else if(length == 0) {
+        throw std::system_error(ECONNRESET, std::system_category(), "zygote has disconnected");
+    }
+
+    int stdout = -1;
+
+    for(struct cmsghdr* it = CMSG_FIRSTHDR(&message); it != nullptr; it = CMSG_NXTHDR(&message, it)) {
+        if(it->cmsg_level == SOL_SOCKET && it->cmsg_type == SCM_RIGHTS) {
+            std::memcpy(&stdout, CMSG_DATA(it), sizeof(int));
+        }
+    }
+
+    if(stdout == -1) {
+        throw std::system_error(EBADMSG, std::system_category(), "zygote has not passed the output pipe");
+    }
+
+    pid_t pid = 0;
+
+    try {
+        msgpack::unpacked unpacked;
+
+        msgpack::unpack(&unpacked, response, length);
+
+        io::type_traits<pid_t>::unpack(unpacked.get(), pid);
+    } catch(const std::exception& e) {
+        ::close(stdout);
+        throw std::system_error(EBADMSG, std::system_category(), "zygote has sent a corrupted response");
+    }
+
+    COCAINE_LOG_DEBUG(m_log, "zygote has forked worker %d", pid);
+
+    return std::make_unique<zygote_handle_t>(pid, stdout);
+}
+
+void
+zygote_t::reset() {
+    if(m_control != -1) {
+        ::close(m_control);
+    }
+
+    m_control = -1;
+
+    // NOTE: The drainer must be stopped before the zygote output pipe is closed.
+    m_drainer.reset();
+
+    // NOTE: This sends the termination signal to the zygote.
+    m_zygote.reset();
+}
@@ -33,6 +33,7 @@
 
 #include "cocaine/detail/actor.hpp"
 #include "cocaine/detail/group.hpp"
+#include "cocaine/detail/workers.hpp"
 
 #include "cocaine/idl/streaming.hpp"
 
@@ -55,6 +56,20 @@ using namespace std::placeholders;
 
 #include "routing.inl"
 
+namespace {
+
+// Time limit to connect to a remote node once its hostname is resolved.
+const float connect_timeout = 5.0f;
+
+// Number of threads for the hostname resolution, so that a single stuck lookup doesn't hold back
+// the rest of the nodes.
+const size_t resolver_threads = 4;
+
+// Delay before the next endpoint is tried in parallel, if the previous ones haven't connected yet.
+const float connect_attempt_delay = 0.25f;
+
+} // namespace
+
 locator_t::locator_t(context_t& context, reactor_t& reactor):
     implements<io::locator_tag>(context, "service/locator"),
     m_context(context),
@@ -88,7 +103,8 @@ locator_t::locator_t(context_t& context, reactor_t& reactor):
 }
 
 locator_t::~locator_t() {
-    // Empty.
+    // NOTE: Wait for the pending name resolution to finish before anything else is destroyed.
+    m_resolver.reset();
 }
 
 void
@@ -127,6 +143,8 @@ locator_t::connect() {
         m_sink_watcher->set<locator_t, &locator_t::on_announce_event>(this);
         m_sink_watcher->start(m_sink->fd(), ev::READ);
 
+        m_resolver = std::make_unique<worker_pool_t>("locator/resolve", resolver_threads);
+
         m_gateway = m_context.get<api::gateway_t>(
             m_context.config.network.gateway.get().type,
             m_context,
@@ -225,6 +243,9 @@ class locator_t::remote_client_t:
     const remote_id_t node;
     const std::string uuid;
 
+    // Version of the last applied update, deltas must follow it without gaps.
+    boost::optional<uint64_t> version;
+
 public:
     typedef io::event_traits<io::locator::synchronize>::drain_type tag;
     typedef io::protocol<tag>::type protocol;
@@ -242,7 +263,15 @@ public:
             auto service = impl.lock();
 
             io::invoke<event_traits<protocol::chunk>::tuple_type>::apply(
-                boost::bind(&remote_client_t::announce, service.get(), boost::arg<1>()),
+                boost::bind(
+                    &remote_client_t::announce,
+                    service.get(),
+                    boost::arg<1>(),
+                    boost::arg<2>(),
+                    boost::arg<3>(),
+                    boost::arg<4>(),
+                    boost::arg<5>()
+                ),
                 unpacked
             );
 
@@ -281,10 +310,27 @@ public:
 
 private:
     void
-    announce(const result_of<io::locator::synchronize>::type& dump) {
-        COCAINE_LOG_INFO(impl.m_log, "node '%s' has been updated", uuid);
+    announce(uint64_t version_, bool full, const synchronize_dump_type& dump,
+             const synchronize_removed_type& removed, const synchronize_load_type& load)
+    {
+        std::pair<router_t::services_vector_t, router_t::services_vector_t> diff;
+
+        if(full) {
+            diff = impl.m_router->update_remote(uuid, dump);
+        } else if(!version || version_ != version.get() + 1) {
+            COCAINE_LOG_WARNING(impl.m_log, "node '%s' has sent an out of order update, resynchronizing", uuid);
+
+            // The remote will be rediscovered on its next announce and send the full dump again.
+            return shutdown();
+        } else {
+            diff = impl.m_router->apply_remote(uuid, dump, removed);
+        }
+
+        version = version_;
 
-        auto diff = impl.m_router->update_remote(uuid, dump);
+        if(!diff.first.empty() || !diff.second.empty()) {
+            COCAINE_LOG_INFO(impl.m_log, "node '%s' has been updated", uuid);
+        }
 
         for(auto it = diff.second.begin(); it != diff.second.end(); ++it) {
             impl.m_gateway->cleanup(uuid, it->first);
@@ -293,6 +339,8 @@ private:
         for(auto it = diff.first.begin(); it != diff.first.end(); ++it) {
             impl.m_gateway->consume(uuid, it->first, it->second);
         }
+
+        impl.m_gateway->update(uuid, load);
     }
 
     void
@@ -311,6 +359,223 @@ private:
     }
 };
 
+class locator_t::connector_t {
+    typedef io::socket<io::tcp> socket_type;
+
+    struct attempt_t {
+        void
+        on_event(ev::io&, int) {
+            self->on_event(*this);
+        }
+
+        connector_t* self;
+
+        const io::tcp::endpoint endpoint;
+        std::shared_ptr<socket_type> socket;
+        std::unique_ptr<ev::io> watcher;
+    };
+
+    locator_t& impl;
+
+    // Remote node identification.
+    const remote_id_t node;
+    const std::string uuid;
+
+    // Endpoints which haven't been tried yet, interleaved by the address family.
+    std::deque<io::tcp::endpoint> endpoints;
+
+    // Connections in progress.
+    std::vector<std::unique_ptr<attempt_t>> attempts;
+
+    std::unique_ptr<ev::timer> delay;
+    std::unique_ptr<ev::timer> timeout;
+
+public:
+    // Resolves the node hostname on the locator resolver thread.
+    struct resolve_task_t {
+        void
+        operator()() const {
+            std::vector<io::tcp::endpoint> endpoints;
+            std::error_code ec;
+
+            try {
+                endpoints = io::resolver<io::tcp>::query(hostname, port);
+            } catch(const std::system_error& e) {
+                ec = e.code();
+            }
+
+            reactor.post(resolve_action_t{connector, endpoints, ec});
+        }
+
+        io::reactor_t& reactor;
+
+        const std::weak_ptr<connector_t> connector;
+        const std::string hostname;
+        const uint16_t port;
+    };
+
+    // Delivers the resolved endpoints back to the locator reactor.
+    struct resolve_action_t {
+        void
+        operator()() const {
+            auto ptr = connector.lock();
+
+            if(ptr) {
+                ptr->on_resolve(endpoints, ec);
+            }
+        }
+
+        const std::weak_ptr<connector_t> connector;
+        const std::vector<io::tcp::endpoint> endpoints;
+        const std::error_code ec;
+    };
+
+    connector_t(locator_t& impl_, const remote_id_t& node_):
+        impl(impl_),
+        node(node_),
+        uuid(std::get<0>(node)),
+        delay(new ev::timer(impl.m_reactor.native())),
+        timeout(new ev::timer(impl.m_reactor.native()))
+    {
+        delay->set<connector_t, &connector_t::on_delay>(this);
+
+        timeout->set<connector_t, &connector_t::on_timeout>(this);
+    }
+
+private:
+    void
+    on_resolve(const std::vector<io::tcp::endpoint>& resolved, const std::error_code& ec) {
+        // NOTE: The timeout starts only now, so that the connector stays in place until its lookup
+        // is complete, however long it takes. This way every node has at most one lookup queued.
+        timeout->start(connect_timeout);
+
+        if(ec) {
+            COCAINE_LOG_ERROR(impl.m_log, "unable to resolve node '%s' endpoints - [%d] %s", uuid, ec.value(),
+                ec.message());
+            return finish(std::shared_ptr<socket_type>());
+        }
+
+        std::deque<io::tcp::endpoint> v4, v6;
+
+        for(auto it = resolved.begin(); it != resolved.end(); ++it) {
+            (it->address().is_v6() ? v6 : v4).push_back(*it);
+        }
+
+        // NOTE: Alternate the address families, starting with the one the resolver prefers, so
+        // that a broken network path of one family doesn't delay the connection much.
+        bool prefer_v6 = !resolved.empty() && resolved.front().address().is_v6();
+
+        while(!v4.empty() || !v6.empty()) {
+            auto& queue = prefer_v6 ? (v6.empty() ? v4 : v6) : (v4.empty() ? v6 : v4);
+
+            endpoints.push_back(queue.front());
+            queue.pop_front();
+
+            prefer_v6 = !prefer_v6;
+        }
+
+        launch();
+    }
+
+    void
+    launch() {
+        delay->stop();
+
+        while(!endpoints.empty()) {
+            const io::tcp::endpoint endpoint = endpoints.front();
+
+            endpoints.pop_front();
+
+            std::error_code ec;
+            std::shared_ptr<socket_type> socket;
+
+            try {
+                socket = std::make_shared<socket_type>(endpoint, ec);
+            } catch(const std::system_error& e) {
+                ec = e.code();
+            }
+
+            if(ec) {
+                COCAINE_LOG_WARNING(impl.m_log, "unable to connect to node '%s' via endpoint '%s' - [%d] %s", uuid,
+                    endpoint, ec.value(), ec.message());
+                continue;
+            }
+
+            std::unique_ptr<attempt_t> attempt(new attempt_t{this, endpoint, socket, nullptr});
+
+            attempt->watcher.reset(new ev::io(impl.m_reactor.native()));
+            attempt->watcher->set<attempt_t, &attempt_t::on_event>(attempt.get());
+            attempt->watcher->start(socket->fd(), ev::WRITE);
+
+            attempts.push_back(std::move(attempt));
+
+            if(!endpoints.empty()) {
+                delay->start(connect_attempt_delay);
+            }
+
+            return;
+        }
+
+        if(attempts.empty()) {
+            COCAINE_LOG_ERROR(impl.m_log, "unable to connect to node '%s'", uuid);
+            finish(std::shared_ptr<socket_type>());
+        }
+    }
+
+    void
+    on_event(attempt_t& attempt) {
+        const std::error_code ec = attempt.socket->error();
+
+        if(!ec) {
+            return finish(attempt.socket);
+        }
+
+        COCAINE_LOG_WARNING(impl.m_log, "unable to connect to node '%s' via endpoint '%s' - [%d] %s", uuid,
+            attempt.endpoint, ec.value(), ec.message());
+
+        for(auto it = attempts.begin(); it != attempts.end(); ++it) {
+            if(it->get() == &attempt) {
+                attempts.erase(it);
+                break;
+            }
+        }
+
+        // Don't wait for the delay to expire, try the next endpoint right away.
+        launch();
+    }
+
+    void
+    on_delay(ev::timer&, int) {
+        launch();
+    }
+
+    void
+    on_timeout(ev::timer&, int) {
+        COCAINE_LOG_ERROR(impl.m_log, "unable to connect to node '%s' - the operation has timed out", uuid);
+        finish(std::shared_ptr<socket_type>());
+    }
+
+    void
+    finish(const std::shared_ptr<socket_type>& socket) {
+        delay->stop();
+        timeout->stop();
+
+        for(auto it = attempts.begin(); it != attempts.end(); ++it) {
+            (*it)->watcher->stop();
+        }
+
+        if(socket) {
+            COCAINE_LOG_INFO(impl.m_log, "connected to node '%s' via endpoint '%s'", uuid, socket->remote_endpoint());
+            impl.on_connect(node, socket);
+        }
+
+        // NOTE: This might be called from one of the attempt watchers, so the connector is destroyed
+        // later via reactor_t::post(). It's safe, because the node won't be connected to again while
+        // the connector is still there.
+        impl.m_reactor.post(deferred_erase_action<decltype(impl.m_connecting)>{impl.m_connecting, node});
+    }
+};
+
 void
 locator_t::on_announce_event(ev::io&, int) {
     char buffers[1024];
@@ -344,7 +609,7 @@ locator_t::on_announce_event(ev::io&, int) {
         return;
     }
 
-    if(m_remotes.find(node) != m_remotes.end()) {
+    if(m_remotes.find(node) != m_remotes.end() || m_connecting.find(node) != m_connecting.end()) {
         return;
     }
 
@@ -356,37 +621,21 @@ locator_t::on_announce_event(ev::io&, int) {
 
     COCAINE_LOG_INFO(m_log, "discovered node '%s' on '%s:%d'", uuid, hostname, port);
 
-    std::vector<io::tcp::endpoint> endpoints;
+    auto connector = std::make_shared<connector_t>(*this, node);
 
-    try {
-        endpoints = io::resolver<io::tcp>::query(hostname, port);
-    } catch(const std::system_error& e) {
-        COCAINE_LOG_ERROR(m_log, "unable to resolve node '%s' endpoints - [%d] %s", uuid, e.code().value(),
-            e.code().message());
-        return;
-    }
-
-    std::unique_ptr<io::channel<io::socket<io::tcp>>> channel;
-
-    for(auto it = endpoints.begin(); it != endpoints.end(); ++it) {
-        try {
-            channel = std::make_unique<io::channel<io::socket<io::tcp>>>(
-                m_reactor,
-                std::make_shared<io::socket<io::tcp>>(*it)
-            );
-        } catch(const std::system_error& e) {
-            COCAINE_LOG_WARNING(m_log, "unable to connect to node '%s' via endpoint '%s' - [%d] %s", uuid, *it,
-                e.code().value(), e.code().message());
-            continue;
-        }
+    m_connecting[node] = connector;
 
-        break;
-    }
+    m_resolver->post(connector_t::resolve_task_t{
+        m_reactor,
+        connector,
+        hostname,
+        port
+    });
+}
 
-    if(!channel) {
-        COCAINE_LOG_ERROR(m_log, "unable to connect to node '%s'", hostname);
-        return;
-    }
+void
+locator_t::on_connect(const remote_id_t& node, const std::shared_ptr<io::socket<io::tcp>>& socket) {
+    auto channel = std::make_unique<io::channel<io::socket<io::tcp>>>(m_reactor, socket);
 
     channel->rd->bind(
         std::bind(&locator_t::on_message, this, node, _1),
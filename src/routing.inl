@@ -18,19 +18,39 @@
     along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "cocaine/detail/snapshot.hpp"
+
 #include <random>
 
 typedef result_of<io::locator::synchronize>::type synchronize_result_type;
 
+typedef std::tuple_element<2, synchronize_result_type>::type synchronize_dump_type;
+typedef std::tuple_element<3, synchronize_result_type>::type synchronize_removed_type;
+typedef std::tuple_element<4, synchronize_result_type>::type synchronize_load_type;
+
 namespace routing {
 
+// Per-thread xorshift generator, so that concurrent resolves don't share any random state.
+uint64_t
+random_uint64() {
+    static __thread uint64_t state = 0;
+
+    if(state == 0) {
 #if defined(__clang__) || defined(HAVE_GCC46)
-typedef std::default_random_engine random_generator_t;
-typedef std::uniform_int_distribution<unsigned int> uniform_uint;
+        std::random_device device;
+        state = (static_cast<uint64_t>(device()) << 32) | device();
 #else
-typedef std::minstd_rand0 random_generator_t;
-typedef std::uniform_int<unsigned int> uniform_uint;
+        state = static_cast<uint64_t>(::time(nullptr)) ^ reinterpret_cast<uintptr_t>(&state);
 #endif
+        state |= 1;
+    }
+
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+
+    return state * 2685821657736338717ULL;
+}
 
 struct group_index_t {
     group_index_t();
@@ -69,6 +89,31 @@ private:
     unsigned int m_sum;
 };
 
+// Immutable Vose alias table for the available services of a group: every column holds a service
+// and an alias, so that a weighted choice takes a single random number and no search at all.
+struct alias_table_t {
+    alias_table_t(const group_index_t& group);
+
+    const std::string&
+    select(uint64_t random) const;
+
+private:
+    struct column_t {
+        size_t   service;
+        size_t   alias;
+
+        // The column's own service is selected if the coin is below this threshold, which is in the
+        // [0, sum] range, or its alias otherwise.
+        uint64_t threshold;
+    };
+
+    std::vector<std::string> m_services;
+    std::vector<column_t> m_columns;
+    uint64_t m_sum;
+};
+
+typedef std::map<std::string, std::shared_ptr<const alias_table_t>> alias_table_map_t;
+
 } // namespace routing
 
 using namespace routing;
@@ -89,7 +134,13 @@ class locator_t::router_t {
         remove_local(const std::string& name);
 
         std::pair<services_vector_t, services_vector_t> // added, removed
-        update_remote(const std::string& uuid, const synchronize_result_type& dump);
+        update_remote(const std::string& uuid, const synchronize_dump_type& dump);
+
+        // Applies a delta on top of the known remote node services. Updated services are reported
+        // both as removed and added ones.
+        std::pair<services_vector_t, services_vector_t> // added, removed
+        apply_remote(const std::string& uuid, const synchronize_dump_type& added,
+                     const synchronize_removed_type& removed);
 
         std::map<std::string, resolve_result_type> // services of the removed node
         remove_remote(const std::string& uuid);
@@ -158,7 +209,17 @@ class locator_t::router_t {
             logging::log_t& m_log;
             const locator_t::router_t& m_router;
 
-            mutable random_generator_t m_generator;
+            // Alias tables of the groups with at least one available service.
+            alias_table_map_t m_tables;
+
+            // Published copy of the alias tables for the resolve-time lookups.
+            snapshot<alias_table_map_t> m_snapshot;
+
+            void
+            rebuild(const std::string& name);
+
+            void
+            publish();
         };
 
         groups_t m_groups;
@@ -193,16 +254,91 @@ group_index_t::remove(size_t service_index) {
     m_used_weights[service_index] = 0;
 }
 
+alias_table_t::alias_table_t(const group_index_t& group) {
+    for(size_t i = 0; i < group.services().size(); ++i) {
+        if(group.used_weights()[i] != 0) {
+            m_services.push_back(group.services()[i]);
+        }
+    }
+
+    const size_t size = m_services.size();
+
+    m_columns.resize(size);
+    m_sum = group.sum();
+
+    // NOTE: Weights are scaled by the number of columns, so that the average scaled weight is equal
+    // to the weight sum, and the whole construction stays in exact integer arithmetic.
+    std::vector<uint64_t> scaled;
+    std::vector<size_t> small, large;
+
+    for(size_t i = 0, j = 0; i < group.services().size(); ++i) {
+        if(group.used_weights()[i] != 0) {
+            scaled.push_back(static_cast<uint64_t>(group.used_weights()[i]) * size);
+            (scaled.back() < m_sum ? small : large).push_back(j++);
+        }
+    }
+
+    while(!small.empty() && !large.empty()) {
+        const size_t lesser = small.back(),
+                     greater = large.back();
+
+        small.pop_back();
+
+        m_columns[lesser].service   = lesser;
+        m_columns[lesser].alias     = greater;
+        m_columns[lesser].threshold = scaled[lesser];
+
+        scaled[greater] -= m_sum - scaled[lesser];
+
+        if(scaled[greater] < m_sum) {
+            large.pop_back();
+            small.push_back(greater);
+        }
+    }
+
+    // The rest of the columns are full, save for the rounding which can't happen here.
+    for(auto it = large.begin(); it != large.end(); ++it) {
+        m_columns[*it].service = m_columns[*it].alias = *it;
+        m_columns[*it].threshold = m_sum;
+    }
+
+    for(auto it = small.begin(); it != small.end(); ++it) {
+        m_columns[*it].service = m_columns[*it].alias = *it;
+        m_columns[*it].threshold = m_sum;
+    }
+}
+
+const std::string&
+alias_table_t::select(uint64_t random) const {
+    // NOTE: The column is picked by the high half of the random number, and the coin is the other
+    // half scaled down to the [0, sum) range.
+    const column_t& column = m_columns[(random >> 32) % m_columns.size()];
+    const uint64_t coin = ((random & 0xFFFFFFFF) * m_sum) >> 32;
+
+    return m_services[coin < column.threshold ? column.service : column.alias];
+}
+
 locator_t::router_t::groups_t::groups_t(logging::log_t& log, const router_t& router) :
     m_log(log),
-    m_router(router)
-{
-#if defined(__clang__) || defined(HAVE_GCC46)
-    std::random_device device;
-    m_generator.seed(device());
-#else
-    m_generator.seed(static_cast<unsigned long>(::time(nullptr)));
-#endif
+    m_router(router),
+    m_snapshot(std::make_shared<const alias_table_map_t>())
+{ }
+
+void
+locator_t::router_t::groups_t::rebuild(const std::string& name) {
+    auto group_it = m_groups.find(name);
+
+    if(group_it == m_groups.end() || group_it->second.sum() == 0) {
+        m_tables.erase(name);
+    } else {
+        m_tables[name] = std::make_shared<const alias_table_t>(group_it->second);
+    }
+}
+
+void
+locator_t::router_t::groups_t::publish() {
+    // NOTE: The tables themselves are shared between the snapshots, only the rebuilt ones are new.
+    m_snapshot.store(std::make_shared<const alias_table_map_t>(m_tables));
 }
 
 void
@@ -219,6 +355,9 @@ locator_t::router_t::groups_t::add_group(const std::string& name, const std::map
             group_it->second.add(i);
         }
     }
+
+    rebuild(name);
+    publish();
 }
 
 void
@@ -244,6 +383,9 @@ locator_t::router_t::groups_t::remove_group(const std::string& name) {
 
     m_groups.erase(group_it);
 
+    rebuild(name);
+    publish();
+
     COCAINE_LOG_INFO((&m_log), "group '%s' has been removed", name);
 }
 
@@ -257,7 +399,10 @@ locator_t::router_t::groups_t::add_service(const std::string& name) {
 
     for(auto it = service_it->second.begin(); it != service_it->second.end(); ++it) {
         m_groups[it->first].add(it->second);
+        rebuild(it->first);
     }
+
+    publish();
 }
 
 void
@@ -270,29 +415,22 @@ locator_t::router_t::groups_t::remove_service(const std::string& name) {
 
     for(auto it = service_it->second.begin(); it != service_it->second.end(); ++it) {
         m_groups[it->first].remove(it->second);
+        rebuild(it->first);
     }
+
+    publish();
 }
 
 std::string
 locator_t::router_t::groups_t::select_service(const std::string& group_name) const {
-    auto group_it = m_groups.find(group_name);
+    const auto tables = m_snapshot.load();
+    const auto table_it = tables->find(group_name);
 
-    if(group_it == m_groups.end() || group_it->second.sum() == 0) {
+    if(table_it == tables->end()) {
         return group_name;
     }
 
-    uniform_uint distribution(1, group_it->second.sum());
-    unsigned int max = distribution(m_generator);
-
-    for(size_t i = 0; i < group_it->second.services().size(); ++i) {
-        if(max <= group_it->second.used_weights()[i]) {
-            return group_it->second.services()[i];
-        } else {
-            max -= group_it->second.used_weights()[i];
-        }
-    }
-
-    return group_name;
+    return table_it->second->select(random_uint64());
 }
 
 locator_t::router_t::router_t(logging::log_t& log):
@@ -316,7 +454,7 @@ locator_t::router_t::remove_local(const std::string& name) {
 }
 
 auto
-locator_t::router_t::update_remote(const std::string& uuid, const synchronize_result_type& dump)
+locator_t::router_t::update_remote(const std::string& uuid, const synchronize_dump_type& dump)
     -> std::pair<services_vector_t, services_vector_t>
 {
     services_vector_t added, removed;
@@ -361,6 +499,42 @@ locator_t::router_t::update_remote(const std::string& uuid, const synchronize_re
     return std::make_pair(std::move(added), std::move(removed));
 }
 
+auto
+locator_t::router_t::apply_remote(const std::string& uuid, const synchronize_dump_type& dump,
+                                  const synchronize_removed_type& names)
+    -> std::pair<services_vector_t, services_vector_t>
+{
+    services_vector_t added, removed;
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    // NOTE: The inverted index entry for this node is looked up every time, because it is erased
+    // as soon as the node has no services left.
+    for(auto it = names.begin(); it != names.end(); ++it) {
+        auto uuid_it = m_inverted.find(uuid);
+
+        if(uuid_it == m_inverted.end() || !uuid_it->second.count(*it)) {
+            continue;
+        }
+
+        removed.push_back(*uuid_it->second.find(*it));
+        remove(uuid, *it);
+    }
+
+    for(auto it = dump.begin(); it != dump.end(); ++it) {
+        auto uuid_it = m_inverted.find(uuid);
+
+        if(uuid_it != m_inverted.end() && uuid_it->second.count(it->first)) {
+            removed.push_back(*uuid_it->second.find(it->first));
+            remove(uuid, it->first);
+        }
+
+        added.push_back(*it);
+        add(uuid, it->first, it->second);
+    }
+
+    return std::make_pair(std::move(added), std::move(removed));
+}
+
 auto
 locator_t::router_t::remove_remote(const std::string& uuid)
     -> std::map<std::string, resolve_result_type>
@@ -413,7 +587,7 @@ locator_t::router_t::remove_group(const std::string& name) {
 
 std::string
 locator_t::router_t::select_service(const std::string& name) const {
-    std::lock_guard<std::mutex> guard(m_mutex);
+    // NOTE: No locking here, as the groups are selected from the published alias table snapshot.
     return m_groups.select_service(name);
 }
 
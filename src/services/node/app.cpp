@@ -30,6 +30,7 @@
 #include "cocaine/context.hpp"
 
 #include "cocaine/detail/actor.hpp"
+#include "cocaine/detail/atomic.hpp"
 
 #include "cocaine/detail/services/node/engine.hpp"
 #include "cocaine/detail/services/node/event.hpp"
@@ -50,6 +51,7 @@
 #include "cocaine/traits/dynamic.hpp"
 #include "cocaine/traits/literal.hpp"
 
+#include <mutex>
 #include <tuple>
 
 #define BOOST_BIND_NO_PLACEHOLDERS
@@ -168,12 +170,432 @@ private:
     }
 };
 
+// Request coalescing
+
+// Maximum response size which is buffered to be replayed to the late subscribers.
+const size_t flight_replay_limit = 1024 * 1024;
+
+// Maximum request body size which is buffered to be matched against the running invocations.
+const size_t coalesce_body_limit = 64 * 1024;
+
+// Incremental FNV-1a hash, so that the request body can be hashed chunk by chunk as it arrives.
+struct body_hash_t {
+    body_hash_t():
+        value(14695981039346656037ULL)
+    { }
+
+    void
+    update(const char* chunk, size_t size) {
+        for(size_t i = 0; i < size; ++i) {
+            value = (value ^ static_cast<unsigned char>(chunk[i])) * 1099511628211ULL;
+        }
+    }
+
+    uint64_t value;
+};
+
+class flight_t;
+
+struct flight_table_t {
+    flight_table_t():
+        coalesced(0)
+    { }
+
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<flight_t>> flights;
+
+    // Number of requests which were attached to an already running invocation.
+    std::atomic<uint64_t> coalesced;
+};
+
+class flight_t:
+    public api::stream_t
+{
+    COCAINE_DECLARE_NONCOPYABLE(flight_t)
+
+    const std::weak_ptr<flight_table_t> m_table;
+    const std::string m_key;
+
+    // The request body of the invocation. Flights are keyed by the body hash, so the body itself is
+    // compared to rule out the hash collisions.
+    const std::string m_body;
+
+    std::mutex m_mutex;
+
+    // The response seen so far, replayed to the subscribers which join late. It's dropped as soon
+    // as no more subscribers can join, i.e. once the flight is retired.
+    std::vector<std::string> m_chunks;
+    size_t m_buffered;
+
+    // Retired flights are no longer in the table and don't accept new subscribers.
+    bool m_retired;
+    bool m_closed;
+
+    std::vector<api::stream_ptr_t> m_subscribers;
+
+public:
+    flight_t(const std::shared_ptr<flight_table_t>& table, const std::string& key, std::string&& body):
+        m_table(table),
+        m_key(key),
+        m_body(std::move(body)),
+        m_buffered(0),
+        m_retired(false),
+        m_closed(false)
+    { }
+
+    const std::string&
+    body() const {
+        return m_body;
+    }
+
+    bool
+    subscribe(const api::stream_ptr_t& stream, const std::string& body) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+
+        if(m_retired || body != m_body) {
+            return false;
+        }
+
+        for(auto it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+            stream->write(it->data(), it->size());
+        }
+
+        m_subscribers.push_back(stream);
+
+        return true;
+    }
+
+    virtual
+    void
+    write(const char* chunk, size_t size) {
+        bool retire = false;
+
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+
+            if(!m_retired) {
+                m_chunks.emplace_back(chunk, size);
+                m_buffered += size;
+
+                // Huge responses are not worth keeping around for the late subscribers, they
+                // start their own invocations instead.
+                if(m_buffered > flight_replay_limit) {
+                    retire = m_retired = true;
+
+                    std::vector<std::string>().swap(m_chunks);
+                }
+            }
+
+            for(auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+                (*it)->write(chunk, size);
+            }
+        }
+
+        if(retire) {
+            detach();
+        }
+    }
+
+    virtual
+    void
+    error(int code, const std::string& reason) {
+        // NOTE: The engine might fail a session without closing it afterwards, so the error is
+        // terminal for the flight: it leaves the table right away, so that the error isn't replayed
+        // to the future requests. The subscribers are still closed, if the flight gets closed.
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+
+            m_retired = true;
+
+            std::vector<std::string>().swap(m_chunks);
+
+            for(auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+                (*it)->error(code, reason);
+            }
+        }
+
+        detach();
+    }
+
+    virtual
+    void
+    close() {
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+
+            if(m_closed) {
+                return;
+            }
+
+            m_retired = m_closed = true;
+
+            for(auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+                (*it)->close();
+            }
+
+            m_subscribers.clear();
+
+            std::vector<std::string>().swap(m_chunks);
+        }
+
+        detach();
+    }
+
+private:
+    void
+    detach() {
+        auto table = m_table.lock();
+
+        if(!table) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(table->mutex);
+
+        auto it = table->flights.find(m_key);
+
+        // The entry might already belong to a newer invocation with the same key.
+        if(it != table->flights.end() && it->second.get() == this) {
+            table->flights.erase(it);
+        }
+    }
+};
+
+class coalescing_stream_t:
+    public api::stream_t
+{
+    COCAINE_DECLARE_NONCOPYABLE(coalescing_stream_t)
+
+    app_t& m_app;
+
+    const std::shared_ptr<flight_table_t> m_table;
+    const std::string m_event;
+    const std::string m_tag;
+    const api::stream_ptr_t m_upstream;
+
+    // The request body has to be complete before it can be matched against running invocations.
+    // Bodies larger than the coalescing limit are not buffered, the request is enqueued as usual.
+    std::string m_body;
+    body_hash_t m_hash;
+
+    // Engine request stream, once the request has been enqueued bypassing the coalescing.
+    api::stream_ptr_t m_downstream;
+
+    bool m_closed;
+
+public:
+    coalescing_stream_t(app_t& app,
+                        const std::shared_ptr<flight_table_t>& table,
+                        const std::string& event,
+                        const std::string& tag,
+                        const api::stream_ptr_t& upstream):
+        m_app(app),
+        m_table(table),
+        m_event(event),
+        m_tag(tag),
+        m_upstream(upstream),
+        m_closed(false)
+    { }
+
+    virtual
+    void
+    write(const char* chunk, size_t size) {
+        if(m_closed) {
+            return;
+        }
+
+        if(m_downstream) {
+            m_downstream->write(chunk, size);
+            return;
+        }
+
+        m_body.append(chunk, size);
+        m_hash.update(chunk, size);
+
+        if(m_body.size() > coalesce_body_limit) {
+            bypass();
+        }
+    }
+
+    virtual
+    void
+    error(int code, const std::string& reason) {
+        if(m_closed) {
+            return;
+        }
+
+        m_closed = true;
+
+        if(m_downstream) {
+            m_downstream->error(code, reason);
+            m_downstream->close();
+            return;
+        }
+
+        // The request was aborted by the client before it has been invoked. The upstream is closed
+        // right away, as the request stream might never be closed after an error.
+        m_upstream->close();
+    }
+
+    virtual
+    void
+    close() {
+        if(m_closed) {
+            return;
+        }
+
+        m_closed = true;
+
+        if(m_downstream) {
+            m_downstream->close();
+            return;
+        }
+
+        std::string key;
+
+        key.reserve(m_event.size() + m_tag.size() + 2 + sizeof(m_hash.value));
+        key.append(m_event).push_back('\0');
+        key.append(m_tag).push_back('\0');
+        key.append(reinterpret_cast<const char*>(&m_hash.value), sizeof(m_hash.value));
+
+        std::shared_ptr<flight_t> flight;
+
+        {
+            std::lock_guard<std::mutex> guard(m_table->mutex);
+
+            auto it = m_table->flights.find(key);
+
+            if(it != m_table->flights.end() && it->second->subscribe(m_upstream, m_body)) {
+                m_table->coalesced++;
+                return;
+            }
+
+            flight = std::make_shared<flight_t>(m_table, key, std::move(m_body));
+            flight->subscribe(m_upstream, flight->body());
+
+            m_table->flights[key] = flight;
+        }
+
+        api::stream_ptr_t downstream;
+
+        try {
+            downstream = enqueue(flight);
+        } catch(const cocaine::error_t& e) {
+            flight->error(resource_error, e.what());
+            flight->close();
+            return;
+        }
+
+        if(!flight->body().empty()) {
+            downstream->write(flight->body().data(), flight->body().size());
+        }
+
+        downstream->close();
+    }
+
+private:
+    api::stream_ptr_t
+    enqueue(const api::stream_ptr_t& upstream) {
+        if(m_tag.empty()) {
+            return m_app.enqueue(api::event_t(m_event), upstream);
+        } else {
+            return m_app.enqueue(api::event_t(m_event), upstream, m_tag);
+        }
+    }
+
+    // Enqueues the request right away without coalescing it, because its body is too large to be
+    // buffered. The rest of the body is streamed as it comes.
+    void
+    bypass() {
+        try {
+            m_downstream = enqueue(m_upstream);
+        } catch(const cocaine::error_t& e) {
+            m_upstream->error(resource_error, e.what());
+            m_upstream->close();
+            m_closed = true;
+            return;
+        }
+
+        m_downstream->write(m_body.data(), m_body.size());
+
+        std::string().swap(m_body);
+    }
+};
+
+// Batch invocation
+
+struct batch_t {
+    batch_t(const std::shared_ptr<upstream_t>& upstream_, size_t size):
+        upstream(upstream_),
+        pending(size)
+    { }
+
+    const std::shared_ptr<upstream_t> upstream;
+
+    // Number of batch entries which are not yet completed.
+    std::atomic<size_t> pending;
+};
+
+class batch_stream_t:
+    public api::stream_t
+{
+    const std::shared_ptr<batch_t> batch;
+    const uint64_t index;
+
+    // Set once the entry completion marker has been sent.
+    std::atomic<bool> finished;
+
+public:
+    typedef io::event_traits<io::app::enqueue_batch>::drain_type tag;
+    typedef io::protocol<tag>::type protocol;
+
+    batch_stream_t(const std::shared_ptr<batch_t>& batch_, uint64_t index_):
+        batch(batch_),
+        index(index_),
+        finished(false)
+    { }
+
+    virtual
+    void
+    write(const char* chunk, size_t size) {
+        batch->upstream->send<protocol::chunk>(index, io::app::enqueue_batch::chunk, 0, literal_t { chunk, size });
+    }
+
+    virtual
+    void
+    error(int code, const std::string& reason) {
+        batch->upstream->send<protocol::chunk>(index, io::app::enqueue_batch::error, code, reason);
+
+        // NOTE: The engine might fail a session without closing it afterwards, so an error always
+        // completes the entry, otherwise the whole batch would never be completed.
+        close();
+    }
+
+    virtual
+    void
+    close() {
+        if(finished.exchange(true)) {
+            return;
+        }
+
+        batch->upstream->send<protocol::chunk>(index, io::app::enqueue_batch::choke, 0, std::string());
+
+        if(--batch->pending == 0) {
+            batch->upstream->send<protocol::choke>();
+        }
+    }
+};
+
 class app_service_t:
     public implements<io::app_tag>
 {
     context_t& context;
     app_t& app;
 
+    // Events which are eligible for coalescing and the invocations which are currently running.
+    const std::set<std::string> coalesce;
+    const std::shared_ptr<flight_table_t> flights;
+
 private:
     struct engine_stream_adapter_t:
         public api::stream_t
@@ -204,7 +626,7 @@ private:
         }
 
     private:
-        const std::shared_ptr<upstream_t>& upstream;
+        const std::shared_ptr<upstream_t> upstream;
     };
 
     struct enqueue_slot_t:
@@ -227,11 +649,39 @@ private:
         app_service_t& self;
     };
 
+    struct enqueue_batch_slot_t:
+        public basic_slot<io::app::enqueue_batch>
+    {
+        enqueue_batch_slot_t(app_service_t& self_):
+            self(self_)
+        { }
+
+        virtual
+        std::shared_ptr<dispatch_t>
+        operator()(const msgpack::object& unpacked, const std::shared_ptr<upstream_t>& upstream) {
+            return io::invoke<event_traits<io::app::enqueue_batch>::tuple_type>::apply(
+                boost::bind(&app_service_t::enqueue_batch, &self, upstream, boost::arg<1>(), boost::arg<2>()),
+                unpacked
+            );
+        }
+
+    private:
+        app_service_t& self;
+    };
+
     std::shared_ptr<dispatch_t>
     enqueue(const std::shared_ptr<upstream_t>& upstream, const std::string& event, const std::string& tag) {
         api::stream_ptr_t downstream;
 
-        if(tag.empty()) {
+        if(coalesce.count(event)) {
+            downstream = std::make_shared<coalescing_stream_t>(
+                app,
+                flights,
+                event,
+                tag,
+                std::make_shared<engine_stream_adapter_t>(upstream)
+            );
+        } else if(tag.empty()) {
             downstream = app.enqueue(api::event_t(event), std::make_shared<engine_stream_adapter_t>(upstream));
         } else {
             downstream = app.enqueue(api::event_t(event), std::make_shared<engine_stream_adapter_t>(upstream), tag);
@@ -248,14 +698,103 @@ private:
         return service;
     }
 
+    std::shared_ptr<dispatch_t>
+    enqueue_batch(const std::shared_ptr<upstream_t>& upstream,
+                  const std::vector<std::pair<std::string, std::string>>& entries,
+                  const std::string& tag)
+    {
+        if(entries.empty()) {
+            upstream->send<batch_stream_t::protocol::choke>();
+            return std::shared_ptr<dispatch_t>();
+        }
+
+        auto batch = std::make_shared<batch_t>(upstream, entries.size());
+
+        std::vector<api::event_t> events;
+        std::vector<api::stream_ptr_t> upstreams;
+
+        events.reserve(entries.size());
+        upstreams.reserve(entries.size());
+
+        for(size_t i = 0; i < entries.size(); ++i) {
+            events.emplace_back(entries[i].first);
+            upstreams.push_back(std::make_shared<batch_stream_t>(batch, i));
+        }
+
+        std::vector<api::stream_ptr_t> downstreams;
+
+        if(tag.empty()) {
+            downstreams = app.enqueue(events, upstreams);
+        } else {
+            // NOTE: Tagged sessions bypass the engine queue, so there's nothing to batch. Entries
+            // which can't be enqueued fail on their own, so that the rest of the batch proceeds.
+            for(size_t i = 0; i < entries.size(); ++i) {
+                try {
+                    downstreams.push_back(app.enqueue(events[i], upstreams[i], tag));
+                } catch(const cocaine::error_t& e) {
+                    upstreams[i]->error(resource_error, e.what());
+
+                    downstreams.push_back(api::stream_ptr_t());
+                }
+            }
+        }
+
+        for(size_t i = 0; i < entries.size(); ++i) {
+            if(!downstreams[i]) {
+                continue;
+            }
+
+            const std::string& body = entries[i].second;
+
+            if(!body.empty()) {
+                downstreams[i]->write(body.data(), body.size());
+            }
+
+            downstreams[i]->close();
+        }
+
+        // The whole request is already there, so there's no protocol to continue with.
+        return std::shared_ptr<dispatch_t>();
+    }
+
+    dynamic_t
+    info() const {
+        dynamic_t info = app.info();
+
+        if(!coalesce.empty() && info.is_object()) {
+            dynamic_t::object_t coalescing;
+
+            {
+                std::lock_guard<std::mutex> guard(flights->mutex);
+                coalescing["in-flight"] = static_cast<uint64_t>(flights->flights.size());
+            }
+
+            coalescing["coalesced"] = flights->coalesced.load();
+
+            info.as_object()["coalescing"] = coalescing;
+        }
+
+        return info;
+    }
+
 public:
-    app_service_t(context_t& context_, const std::string& name_, app_t& app_):
+    virtual
+    auto
+    load() const -> boost::optional<io::locator::synchronize::load_tuple_type> {
+        return app.load();
+    }
+
+public:
+    app_service_t(context_t& context_, const std::string& name_, app_t& app_, const profile_t& profile):
         implements<io::app_tag>(context_, cocaine::format("service/%1%", name_)),
         context(context_),
-        app(app_)
+        app(app_),
+        coalesce(profile.coalesce),
+        flights(std::make_shared<flight_table_t>())
     {
         on<io::app::enqueue>(std::make_shared<enqueue_slot_t>(*this));
-        on<io::app::info>(std::bind(&app_t::info, std::ref(app)));
+        on<io::app::enqueue_batch>(std::make_shared<enqueue_batch_slot_t>(*this));
+        on<io::app::info>(std::bind(&app_service_t::info, this));
     }
 };
 
@@ -309,13 +848,19 @@ app_t::start() {
     // Start the engine thread.
     m_thread.reset(new std::thread(std::bind(&engine_t::run, m_engine)));
 
+    const auto error = m_profile->cpu_affinity.apply(m_thread->native_handle());
+
+    if(error) {
+        COCAINE_LOG_WARNING(m_log, "unable to bind the engine thread to the CPU set - [%d] %s", error.value(), error.message());
+    }
+
     COCAINE_LOG_DEBUG(m_log, "starting the invocation service");
 
     // Publish the app service.
     m_context.insert(m_manifest->name, std::make_unique<actor_t>(
         m_context,
         std::make_shared<reactor_t>(),
-        std::unique_ptr<dispatch_t>(new app_service_t(m_context, m_manifest->name, *this))
+        std::unique_ptr<dispatch_t>(new app_service_t(m_context, m_manifest->name, *this, *m_profile))
     ));
 
     COCAINE_LOG_INFO(m_log, "the engine has started");
@@ -479,24 +1024,29 @@ app_t::info() const {
         return info;
     }
 
-    auto callback = expect<control::info>(*m_reactor, info);
-
-    m_engine_control->rd->bind(std::ref(callback), std::ref(callback));
-    m_engine_control->wr->write<control::report>(0UL);
+    const auto report = m_engine->info();
 
-    try {
-        // Blocks until either the response or timeout happens.
-        m_reactor->run_with_timeout(defaults::control_timeout);
-    } catch(const cocaine::error_t& e) {
-        info.as_object()["error"] = "the engine is unresponsive";
+    if(!report) {
+        info.as_object()["error"] = "the engine has not yet reported";
         return info;
     }
 
+    // NOTE: The report is shared with other readers, so it's copied to be amended.
+    info = *report;
     info.as_object()["profile"] = m_profile->name;
 
     return info;
 }
 
+boost::optional<std::tuple<uint64_t, uint64_t>>
+app_t::load() const {
+    if(!m_thread) {
+        return boost::none;
+    }
+
+    return m_engine->metrics();
+}
+
 std::shared_ptr<api::stream_t>
 app_t::enqueue(const api::event_t& event, const std::shared_ptr<api::stream_t>& upstream) {
     return m_engine->enqueue(event, upstream);
@@ -506,3 +1056,8 @@ std::shared_ptr<api::stream_t>
 app_t::enqueue(const api::event_t& event, const std::shared_ptr<api::stream_t>& upstream, const std::string& tag) {
     return m_engine->enqueue(event, upstream, tag);
 }
+
+std::vector<std::shared_ptr<api::stream_t>>
+app_t::enqueue(const std::vector<api::event_t>& events, const std::vector<std::shared_ptr<api::stream_t>>& upstreams) {
+    return m_engine->enqueue(events, upstreams);
+}
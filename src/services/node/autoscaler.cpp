@@ -0,0 +1,143 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cocaine/detail/services/node/autoscaler.hpp"
+#include "cocaine/detail/services/node/profile.hpp"
+
+#include <cmath>
+
+using namespace cocaine;
+using namespace cocaine::engine;
+
+namespace {
+
+const char* describe[] = {
+    "hold",
+    "grow",
+    "shrink"
+};
+
+inline
+double
+smooth(double average, double sample, double alpha) {
+    return average + alpha * (sample - average);
+}
+
+} // namespace
+
+autoscaler_t::autoscaler_t(const profile_t& profile):
+    m_profile(profile),
+    m_alpha(1.0 - std::exp(-profile.autoscaling.interval / profile.autoscaling.window)),
+    m_arrivals(0),
+    m_started(0),
+    m_finished(0),
+    m_wait_sum(0.0),
+    m_duration_sum(0.0),
+    m_arrival_rate(0.0),
+    m_queue_wait(0.0),
+    m_service_time(0.0),
+    m_target(0),
+    m_decision(decisions::hold),
+    m_surplus(0.0f)
+{ }
+
+void
+autoscaler_t::arrived() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    ++m_arrivals;
+}
+
+void
+autoscaler_t::started(double wait) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    ++m_started;
+    m_wait_sum += wait;
+}
+
+void
+autoscaler_t::finished(double duration) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    ++m_finished;
+    m_duration_sum += duration;
+}
+
+autoscaler_t::decisions
+autoscaler_t::update(size_t pool, size_t depth) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    m_arrival_rate = smooth(m_arrival_rate, m_arrivals / m_profile.autoscaling.interval, m_alpha);
+
+    // NOTE: Intervals without completed sessions carry no information about the service time, so
+    // the previous estimates are kept intact. The very first sample seeds the average directly.
+    if(m_started) {
+        const double mean = m_wait_sum / m_started;
+        m_queue_wait = m_queue_wait > 0.0 ? smooth(m_queue_wait, mean, m_alpha) : mean;
+    }
+
+    if(m_finished) {
+        const double mean = m_duration_sum / m_finished;
+        m_service_time = m_service_time > 0.0 ? smooth(m_service_time, mean, m_alpha) : mean;
+    }
+
+    m_arrivals = m_started = m_finished = 0;
+    m_wait_sum = m_duration_sum = 0.0;
+
+    // Little's law gives the number of sessions in service, the queued sessions have to be served
+    // on top of that. Slaves are planned to run below their concurrency limit to absorb bursts.
+    const double demand   = m_arrival_rate * m_service_time + depth;
+    const double capacity = m_profile.concurrency * m_profile.autoscaling.utilization;
+
+    m_target = std::min<size_t>(m_profile.pool_limit, std::ceil(demand / capacity));
+
+    if(m_target > pool) {
+        m_decision = decisions::grow;
+        m_surplus = 0.0f;
+    } else if(m_target < pool) {
+        // Only shrink the pool when it has been consistently oversized for the cooldown period,
+        // so that short lulls between bursts don't make the pool oscillate.
+        m_surplus += m_profile.autoscaling.interval;
+        m_decision = m_surplus >= m_profile.autoscaling.cooldown ? decisions::shrink : decisions::hold;
+    } else {
+        m_decision = decisions::hold;
+        m_surplus = 0.0f;
+    }
+
+    return m_decision;
+}
+
+size_t
+autoscaler_t::target() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_target;
+}
+
+dynamic_t
+autoscaler_t::info() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    return dynamic_t::object_t({
+        {"arrival-rate", m_arrival_rate},
+        {"decision", std::string(describe[static_cast<int>(m_decision)])},
+        {"queue-wait", m_queue_wait},
+        {"service-time", m_service_time},
+        {"target", dynamic_t::uint_t(m_target)}
+    });
+}
@@ -0,0 +1,329 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cocaine/detail/services/node/cache.hpp"
+#include "cocaine/detail/services/node/stream.hpp"
+
+using namespace cocaine;
+using namespace cocaine::engine;
+
+namespace {
+
+struct recorder_t:
+    public api::stream_t
+{
+    recorder_t(const std::shared_ptr<response_cache_t>& cache,
+               const std::string& key,
+               float ttl,
+               const std::shared_ptr<api::stream_t>& upstream):
+        m_cache(cache),
+        m_key(key),
+        m_ttl(ttl),
+        m_upstream(upstream),
+        m_response(new response_cache_t::response_type()),
+        m_size(key.size()),
+        m_failed(false)
+    { }
+
+    virtual
+    void
+    write(const char* chunk, size_t size) {
+        m_upstream->write(chunk, size);
+
+        if(m_failed) {
+            return;
+        }
+
+        // NOTE: Responses which don't fit into the cache are not recorded at all.
+        if((m_size += size) > m_cache->capacity()) {
+            m_failed = true;
+            m_response.reset();
+        } else {
+            m_response->emplace_back(chunk, size);
+        }
+    }
+
+    virtual
+    void
+    error(int code, const std::string& reason) {
+        m_failed = true;
+        m_upstream->error(code, reason);
+    }
+
+    virtual
+    void
+    close() {
+        if(!m_failed) {
+            m_cache->put(m_key, m_response, m_ttl);
+        }
+
+        m_upstream->close();
+    }
+
+private:
+    const std::shared_ptr<response_cache_t> m_cache;
+    const std::string m_key;
+    const float m_ttl;
+    const std::shared_ptr<api::stream_t> m_upstream;
+
+    std::shared_ptr<response_cache_t::response_type> m_response;
+
+    size_t m_size;
+    bool m_failed;
+};
+
+struct request_t:
+    public api::stream_t
+{
+    request_t(const std::shared_ptr<response_cache_t>& cache,
+              const std::string& event,
+              float ttl,
+              const std::shared_ptr<api::stream_t>& upstream,
+              response_cache_t::handler_type handler):
+        m_cache(cache),
+        m_key(event + '\0'),
+        m_offset(m_key.size()),
+        m_ttl(ttl),
+        m_upstream(upstream),
+        m_handler(handler),
+        m_closed(false)
+    { }
+
+    virtual
+    void
+    write(const char* chunk, size_t size) {
+        if(m_closed) {
+            return;
+        }
+
+        if(m_downstream) {
+            m_downstream->write(chunk, size);
+            return;
+        }
+
+        m_key.append(chunk, size);
+
+        if(m_key.size() - m_offset > m_cache->body_limit()) {
+            bypass();
+        }
+    }
+
+    virtual
+    void
+    error(int code, const std::string& reason) {
+        if(m_downstream) {
+            m_downstream->error(code, reason);
+        }
+
+        // Otherwise the request has been aborted by the client before it has been handed to the
+        // engine.
+        m_closed = true;
+    }
+
+    virtual
+    void
+    close() {
+        if(m_closed) {
+            return;
+        }
+
+        m_closed = true;
+
+        if(m_downstream) {
+            m_downstream->close();
+            return;
+        }
+
+        const auto response = m_cache->get(m_key);
+
+        if(response) {
+            for(auto it = response->begin(); it != response->end(); ++it) {
+                m_upstream->write(it->data(), it->size());
+            }
+
+            m_upstream->close();
+
+            return;
+        }
+
+        std::shared_ptr<api::stream_t> downstream;
+
+        try {
+            downstream = m_handler(std::make_shared<recorder_t>(m_cache, m_key, m_ttl, m_upstream));
+        } catch(const std::exception& e) {
+            m_upstream->error(resource_error, e.what());
+            m_upstream->close();
+            return;
+        }
+
+        // NOTE: The request body is passed to the app as a single chunk.
+        if(m_offset != m_key.size()) {
+            downstream->write(m_key.data() + m_offset, m_key.size() - m_offset);
+        }
+
+        downstream->close();
+    }
+
+private:
+    // Hands the request over to the engine right away, bypassing the cache, because its body is too
+    // large to be buffered. The rest of the body is streamed as it comes.
+    void
+    bypass() {
+        try {
+            m_downstream = m_handler(m_upstream);
+        } catch(const std::exception& e) {
+            m_upstream->error(resource_error, e.what());
+            m_upstream->close();
+            m_closed = true;
+            return;
+        }
+
+        m_downstream->write(m_key.data() + m_offset, m_key.size() - m_offset);
+
+        std::string().swap(m_key);
+    }
+
+private:
+    const std::shared_ptr<response_cache_t> m_cache;
+
+    // The event name and the request body, separated by a null character.
+    std::string m_key;
+    const size_t m_offset;
+
+    const float m_ttl;
+    const std::shared_ptr<api::stream_t> m_upstream;
+    const response_cache_t::handler_type m_handler;
+
+    // Request stream of the engine, if the cache has been bypassed.
+    std::shared_ptr<api::stream_t> m_downstream;
+
+    bool m_closed;
+};
+
+} // namespace
+
+response_cache_t::response_cache_t(size_t capacity, size_t body_limit):
+    m_capacity(capacity),
+    m_body_limit(body_limit),
+    m_size(0),
+    m_hits(0),
+    m_misses(0),
+    m_evictions(0)
+{ }
+
+std::shared_ptr<api::stream_t>
+response_cache_t::wrap(const std::string& event, float ttl, const std::shared_ptr<api::stream_t>& upstream, handler_type handler) {
+    return std::make_shared<request_t>(shared_from_this(), event, ttl, upstream, handler);
+}
+
+std::shared_ptr<const response_cache_t::response_type>
+response_cache_t::get(const std::string& key) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    entry_map_t::iterator it = m_entries.find(key);
+
+    if(it == m_entries.end()) {
+        ++m_misses;
+        return std::shared_ptr<const response_type>();
+    }
+
+    if(it->second.expiration <= session_t::clock_type::now()) {
+        m_size -= it->second.footprint;
+        m_usage.erase(it->second.position);
+        m_entries.erase(it);
+
+        ++m_misses;
+        return std::shared_ptr<const response_type>();
+    }
+
+    // Move the entry to the front of the usage list.
+    m_usage.splice(m_usage.begin(), m_usage, it->second.position);
+
+    ++m_hits;
+    return it->second.response;
+}
+
+void
+response_cache_t::put(const std::string& key, const std::shared_ptr<const response_type>& response, float ttl) {
+    size_t footprint = key.size();
+
+    for(auto it = response->begin(); it != response->end(); ++it) {
+        footprint += it->size();
+    }
+
+    if(footprint > m_capacity) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    entry_map_t::iterator it = m_entries.find(key);
+
+    if(it != m_entries.end()) {
+        // Some concurrent request has already cached the same response.
+        m_size -= it->second.footprint;
+        m_usage.erase(it->second.position);
+        m_entries.erase(it);
+    }
+
+    evict(footprint);
+
+    m_usage.push_front(key);
+
+    entry_t entry = {
+        response,
+        session_t::clock_type::now() + std::chrono::duration_cast<session_t::clock_type::duration>(
+            std::chrono::duration<float>(ttl)
+        ),
+        footprint,
+        m_usage.begin()
+    };
+
+    m_entries.insert(std::make_pair(key, entry));
+    m_size += footprint;
+}
+
+dynamic_t
+response_cache_t::info() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    return dynamic_t::object_t({
+        {"capacity", dynamic_t::uint_t(m_capacity)},
+        {"entries", dynamic_t::uint_t(m_entries.size())},
+        {"evictions", dynamic_t::uint_t(m_evictions)},
+        {"hits", dynamic_t::uint_t(m_hits)},
+        {"misses", dynamic_t::uint_t(m_misses)},
+        {"size", dynamic_t::uint_t(m_size)}
+    });
+}
+
+void
+response_cache_t::evict(size_t required) {
+    while(!m_usage.empty() && m_size + required > m_capacity) {
+        entry_map_t::iterator it = m_entries.find(m_usage.back());
+
+        m_size -= it->second.footprint;
+        m_entries.erase(it);
+        m_usage.pop_back();
+
+        ++m_evictions;
+    }
+}
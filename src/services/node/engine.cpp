@@ -28,7 +28,10 @@
 
 #include "cocaine/context.hpp"
 
+#include "cocaine/detail/services/node/autoscaler.hpp"
+#include "cocaine/detail/services/node/cache.hpp"
 #include "cocaine/detail/services/node/event.hpp"
+#include "cocaine/detail/services/node/histogram.hpp"
 #include "cocaine/detail/services/node/manifest.hpp"
 #include "cocaine/detail/services/node/messages.hpp"
 #include "cocaine/detail/services/node/profile.hpp"
@@ -46,6 +49,8 @@
 #include "cocaine/traits/dynamic.hpp"
 #include "cocaine/traits/literal.hpp"
 
+#include <cmath>
+
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/median.hpp>
 #include <boost/accumulators/statistics/sum.hpp>
@@ -60,6 +65,16 @@ using namespace std::placeholders;
 
 namespace {
 
+// Maximum number of times a session is rescheduled after its slave has died before it's started,
+// so that an app which never starts or a session which kills its slaves doesn't respawn forever.
+const unsigned int requeue_limit = 3;
+
+// Maximum number of distinct events with their own statistics. The event names come from the
+// clients, so the rest of them is accounted under a single shared entry, to keep the memory bound.
+const size_t statistics_limit = 64;
+
+const char* const statistics_overflow = "<other>";
+
 struct ignore {
     void
     operator()(const std::error_code& /* ec */) const {
@@ -67,6 +82,29 @@ struct ignore {
     }
 };
 
+// Request stream for the rejected sessions.
+struct discard_t:
+    public api::stream_t
+{
+    virtual
+    void
+    write(const char* /* chunk */, size_t /* size */) {
+        // Do nothing.
+    }
+
+    virtual
+    void
+    error(int /* code */, const std::string& /* reason */) {
+        // Do nothing.
+    }
+
+    virtual
+    void
+    close() {
+        // Do nothing.
+    }
+};
+
 } // namespace
 
 engine_t::engine_t(context_t& context,
@@ -82,11 +120,41 @@ engine_t::engine_t(context_t& context,
     m_reactor(reactor),
     m_notification(new ev::async(m_reactor->native())),
     m_termination_timer(new ev::timer(m_reactor->native())),
-    m_next_id(1)
+    m_autoscaling_timer(new ev::timer(m_reactor->native())),
+    m_report_timer(new ev::timer(m_reactor->native())),
+    m_steal_timer(new ev::timer(m_reactor->native())),
+    m_next_id(1),
+    m_stolen(0),
+    m_load_depth(0),
+    m_load_active(0)
 {
     m_notification->set<engine_t, &engine_t::on_notification>(this);
     m_notification->start();
 
+    if(!m_profile.cache.events.empty()) {
+        m_cache = std::make_shared<response_cache_t>(m_profile.cache.size, m_profile.cache.body_limit);
+    }
+
+    if(m_profile.autoscaling.enabled) {
+        m_autoscaler.reset(new autoscaler_t(m_profile));
+
+        m_autoscaling_timer->set<engine_t, &engine_t::on_autoscaling>(this);
+        m_autoscaling_timer->start(m_profile.autoscaling.interval, m_profile.autoscaling.interval);
+    }
+
+    if(m_profile.shedding.enabled) {
+        m_queue.control(m_profile.shedding.target, m_profile.shedding.interval);
+    }
+
+    m_report_timer->set<engine_t, &engine_t::on_report>(this);
+    m_report_timer->start(m_profile.report_interval, m_profile.report_interval);
+
+    if(m_profile.steal_threshold > 0.0f) {
+        // NOTE: Checking twice per threshold keeps the sessions from waiting much longer than that.
+        m_steal_timer->set<engine_t, &engine_t::on_steal>(this);
+        m_steal_timer->start(m_profile.steal_threshold / 2, m_profile.steal_threshold / 2);
+    }
+
     const auto endpoint = local::endpoint(m_manifest.endpoint);
 
     m_connector.reset(new connector<acceptor<local>>(
@@ -126,6 +194,10 @@ engine_t::~engine_t() {
 void
 engine_t::run() {
     m_state = states::running;
+
+    // Publish the initial report, so that it's available right away.
+    publish();
+
     m_reactor->run();
 }
 
@@ -135,6 +207,23 @@ engine_t::enqueue(const api::event_t& event, const std::shared_ptr<api::stream_t
         throw cocaine::error_t("the engine is not active");
     }
 
+    if(m_cache) {
+        const auto it = m_profile.cache.events.find(event.name);
+
+        if(it != m_profile.cache.events.end()) {
+            return m_cache->wrap(event.name, it->second, upstream, std::bind(&engine_t::push, this, event, _1));
+        }
+    }
+
+    return push(event, upstream);
+}
+
+std::shared_ptr<api::stream_t>
+engine_t::push(const api::event_t& event, const std::shared_ptr<api::stream_t>& upstream) {
+    if(m_state != states::running) {
+        throw cocaine::error_t("the engine is not active");
+    }
+
     auto session = std::make_shared<session_t>(
         m_next_id++,
         event,
@@ -142,7 +231,7 @@ engine_t::enqueue(const api::event_t& event, const std::shared_ptr<api::stream_t
     );
 
     {
-        std::lock_guard<session_queue_t> queue_guard(m_queue);
+        std::unique_lock<session_queue_t> queue_guard(m_queue);
 
         if(m_profile.queue_limit > 0 &&
            m_queue.size() >= m_profile.queue_limit)
@@ -150,26 +239,146 @@ engine_t::enqueue(const api::event_t& event, const std::shared_ptr<api::stream_t
             throw cocaine::error_t("the queue is full");
         }
 
+        if(!m_queue.admit()) {
+            queue_guard.unlock();
+
+            // NOTE: The session is rejected right away, so the client can retry it elsewhere instead
+            // of waiting in a queue which is not going to be drained in time.
+            upstream->error(overload_error, "the queue is overloaded");
+            upstream->close();
+
+            return std::make_shared<discard_t>();
+        }
+
         m_queue.push(session);
     }
 
+    if(m_autoscaler) {
+        m_autoscaler->arrived();
+    }
+
     wake();
 
     return std::make_shared<session_t::downstream_t>(session);
 }
 
+std::vector<std::shared_ptr<api::stream_t>>
+engine_t::enqueue(const std::vector<api::event_t>& events, const std::vector<std::shared_ptr<api::stream_t>>& upstreams) {
+    BOOST_ASSERT(events.size() == upstreams.size());
+
+    if(m_state != states::running) {
+        throw cocaine::error_t("the engine is not active");
+    }
+
+    std::vector<std::shared_ptr<api::stream_t>> downstreams(events.size());
+    std::vector<std::pair<size_t, std::shared_ptr<session_t>>> sessions;
+
+    sessions.reserve(events.size());
+
+    for(size_t i = 0; i < events.size(); ++i) {
+        if(m_cache) {
+            const auto it = m_profile.cache.events.find(events[i].name);
+
+            if(it != m_profile.cache.events.end()) {
+                downstreams[i] = m_cache->wrap(events[i].name, it->second, upstreams[i], std::bind(
+                    &engine_t::push,
+                    this,
+                    events[i],
+                    _1
+                ));
+
+                continue;
+            }
+        }
+
+        sessions.emplace_back(i, std::make_shared<session_t>(m_next_id++, events[i], upstreams[i]));
+    }
+
+    if(sessions.empty()) {
+        return downstreams;
+    }
+
+    {
+        std::unique_lock<session_queue_t> queue_guard(m_queue);
+
+        if(m_profile.queue_limit > 0 &&
+           m_queue.size() + sessions.size() > m_profile.queue_limit)
+        {
+            throw cocaine::error_t("the queue is full");
+        }
+
+        if(!m_queue.admit()) {
+            queue_guard.unlock();
+
+            for(auto it = sessions.begin(); it != sessions.end(); ++it) {
+                it->second->upstream->error(overload_error, "the queue is overloaded");
+                it->second->upstream->close();
+
+                downstreams[it->first] = std::make_shared<discard_t>();
+            }
+
+            return downstreams;
+        }
+
+        for(auto it = sessions.begin(); it != sessions.end(); ++it) {
+            m_queue.push(it->second);
+        }
+    }
+
+    for(auto it = sessions.begin(); it != sessions.end(); ++it) {
+        downstreams[it->first] = std::make_shared<session_t::downstream_t>(it->second);
+
+        if(m_autoscaler) {
+            m_autoscaler->arrived();
+        }
+    }
+
+    wake();
+
+    return downstreams;
+}
+
 std::shared_ptr<api::stream_t>
 engine_t::enqueue(const api::event_t& event, const std::shared_ptr<api::stream_t>& upstream, const std::string& tag) {
     if(m_state != states::running) {
         throw cocaine::error_t("the engine is not active");
     }
 
+    if(m_profile.hashed_affinity) {
+        const auto slave = affine(tag);
+
+        if(!slave) {
+            // NOTE: No warm slave can take the session right now, so it's scheduled as usual.
+            return enqueue(event, upstream);
+        }
+
+        auto session = std::make_shared<session_t>(
+            m_next_id++,
+            event,
+            upstream
+        );
+
+        if(m_autoscaler) {
+            m_autoscaler->arrived();
+        }
+
+        slave->assign(session);
+
+        return std::make_shared<session_t::downstream_t>(session);
+    }
+
     auto session = std::make_shared<session_t>(
         m_next_id++,
         event,
         upstream
     );
 
+    session->pinned = true;
+
+    if(m_autoscaler) {
+        m_autoscaler->arrived();
+    }
+
     pool_map_t::iterator it;
 
     {
@@ -195,16 +404,25 @@ engine_t::enqueue(const api::event_t& event, const std::shared_ptr<api::stream_t
 }
 
 void
-engine_t::erase(const std::string& id, int code, const std::string& reason) {
+engine_t::erase(const std::string& id,
+                int code,
+                const std::string& reason,
+                const std::deque<std::shared_ptr<session_t>>& pending)
+{
     std::lock_guard<std::mutex> pool_guard(m_pool_mutex);
 
     m_pool.erase(id);
+    m_ring.erase(id);
 
     if(code == rpc::terminate::abnormal) {
         COCAINE_LOG_ERROR(m_log, "the app seems to be broken - %s", reason);
         migrate(states::broken);
     }
 
+    if(!pending.empty()) {
+        requeue(id, pending);
+    }
+
     if(m_state != states::running && m_pool.empty()) {
         // If it was the last slave, shut the engine down.
         stop();
@@ -213,6 +431,55 @@ engine_t::erase(const std::string& id, int code, const std::string& reason) {
     }
 }
 
+void
+engine_t::started(const session_t& session) {
+    using namespace std::chrono;
+
+    if(m_autoscaler) {
+        m_autoscaler->started(duration_cast<duration<double>>(
+            session.attachstamp - session.birthstamp
+        ).count());
+    }
+}
+
+void
+engine_t::finished(const session_t& session) {
+    using namespace std::chrono;
+
+    const auto now = session_t::clock_type::now();
+
+    if(m_autoscaler) {
+        m_autoscaler->finished(duration_cast<duration<double>>(
+            now - session.attachstamp
+        ).count());
+    }
+
+    statistics_map_t::iterator it = m_statistics.find(session.event.name);
+
+    if(it == m_statistics.end()) {
+        const std::string name = m_statistics.size() < statistics_limit ? session.event.name : statistics_overflow;
+
+        it = m_statistics.find(name);
+
+        if(it == m_statistics.end()) {
+            it = m_statistics.insert(std::make_pair(
+                name,
+                std::unique_ptr<event_statistics_t>(new event_statistics_t())
+            )).first;
+        }
+    }
+
+    event_statistics_t& statistics = *it->second;
+
+    statistics.queue_wait.record(duration_cast<microseconds>(session.attachstamp - session.birthstamp).count());
+    statistics.duration.record(duration_cast<microseconds>(now - session.attachstamp).count());
+    statistics.response_size.record(session.reply_size);
+
+    if(session.replystamp != session_t::clock_type::time_point()) {
+        statistics.first_chunk.record(duration_cast<microseconds>(session.replystamp - session.attachstamp).count());
+    }
+}
+
 void
 engine_t::wake() {
     m_notification->send();
@@ -241,13 +508,19 @@ engine_t::on_connection(const std::shared_ptr<io::socket<local>>& socket_) {
 void
 engine_t::on_handshake(int fd, const message_t& message) {
     std::string id;
+    uint64_t features = 0;
+
     backlog_t::mapped_type channel_ = m_backlog[fd];
 
     // Pop the channel.
     m_backlog.erase(fd);
 
     try {
-        message.as<rpc::handshake>(id);
+        if(message.args().type == msgpack::type::ARRAY && message.args().via.array.size > 1) {
+            message.as<rpc::handshake>(id, features);
+        } else {
+            message.as<rpc::handshake>(id);
+        }
     } catch(const std::system_error& e) {
         COCAINE_LOG_WARNING(m_log, "disconnecting an incompatible slave on fd %d", fd);
         return;
@@ -269,6 +542,10 @@ engine_t::on_handshake(int fd, const message_t& message) {
     COCAINE_LOG_DEBUG(m_log, "slave %s connected on fd %d", id, fd);
 
     it->second->bind(channel_);
+
+    if(m_profile.shared_memory && (features & rpc::handshake::shared_memory)) {
+        it->second->share(fd);
+    }
 }
 
 void
@@ -331,44 +608,24 @@ private:
 
 } // namespace
 
+std::shared_ptr<const dynamic_t>
+engine_t::info() const {
+    return m_report.load();
+}
+
+std::tuple<uint64_t, uint64_t>
+engine_t::metrics() const {
+    return std::make_tuple(
+        m_load_depth.load(std::memory_order_relaxed),
+        m_load_active.load(std::memory_order_relaxed)
+    );
+}
+
 void
 engine_t::on_control(const message_t& message) {
     std::lock_guard<std::mutex> pool_guard(m_pool_mutex);
 
     switch(message.id()) {
-    case event_traits<control::report>::id: {
-        collector_t collector;
-
-        size_t active = std::count_if(
-            m_pool.begin(),
-            m_pool.end(),
-            std::bind<bool>(std::ref(collector), _1)
-        );
-
-        dynamic_t::object_t info;
-
-        info["load-median"] = dynamic_t::uint_t(collector.median());
-
-        info["queue"] = dynamic_t::object_t({
-            {"capacity", dynamic_t::uint_t(m_profile.queue_limit)},
-            {"depth", dynamic_t::uint_t(m_queue.size())}
-        });
-
-        info["sessions"] = dynamic_t::object_t({
-            {"pending", dynamic_t::uint_t(collector.sum())}
-        });
-
-        info["slaves"] = dynamic_t::object_t({
-            {"active", dynamic_t::uint_t(active)},
-            {"capacity", dynamic_t::uint_t(m_profile.pool_limit)},
-            {"idle", dynamic_t::uint_t(m_pool.size() - active)}
-        });
-
-        info["state"] = std::string(describe[static_cast<int>(m_state)]);
-
-        m_channel->wr->write<control::info>(0UL, dynamic_t(info));
-    } break;
-
     case event_traits<control::terminate>::id: {
         // Prepare for the shutdown.
         migrate(states::stopping);
@@ -383,6 +640,11 @@ engine_t::on_control(const message_t& message) {
     }
 }
 
+void
+engine_t::on_report(ev::timer&, int) {
+    publish();
+}
+
 void
 engine_t::on_notification(ev::async&, int) {
     pump();
@@ -408,13 +670,41 @@ struct load {
     }
 };
 
+struct active {
+    template<class T>
+    bool
+    operator()(const T& slave) const {
+        return slave.second->active();
+    }
+};
+
+struct idle {
+    template<class T>
+    bool
+    operator()(const T& slave) const {
+        return slave.second->active() && slave.second->load() == 0;
+    }
+};
+
 struct available {
     template<class T>
     bool
     operator()(const T& slave) const {
-        return slave.second->active() && slave.second->load() < max;
+        return slave.second->active() && slave.second->load() < slave.second->limit();
     }
+};
+
+struct bounded {
+    bool
+    operator()(const std::string& id) const {
+        const auto it = pool.find(id);
 
+        return it != pool.end() &&
+               it->second->active() &&
+               it->second->load() < std::min(max, it->second->limit());
+    }
+
+    const std::map<std::string, std::shared_ptr<slave_t>>& pool;
     const size_t max;
 };
 
@@ -443,6 +733,112 @@ min_element_if(It first, It last, Compare compare, Predicate predicate) {
 
 } // namespace
 
+std::shared_ptr<slave_t>
+engine_t::affine(const std::string& tag) {
+    std::lock_guard<std::mutex> pool_guard(m_pool_mutex);
+
+    size_t running = 0,
+           sessions = 0;
+
+    for(auto it = m_pool.begin(); it != m_pool.end(); ++it) {
+        if(it->second->active()) {
+            ++running;
+            sessions += it->second->load();
+        }
+    }
+
+    if(!running) {
+        return std::shared_ptr<slave_t>();
+    }
+
+    // NOTE: Consistent hashing with bounded loads. The tag owner is skipped in favor of the next
+    // slave on the ring when it is loaded above the average by more than the allowed factor, so
+    // that hot tags can't overload their slaves while the rest of the pool stays idle.
+    const size_t max = std::ceil((sessions + 1) * 1.25 / running);
+
+    const std::string* id = m_ring.find(tag, bounded { m_pool, max });
+
+    if(!id) {
+        return std::shared_ptr<slave_t>();
+    }
+
+    return m_pool[*id];
+}
+
+void
+engine_t::requeue(const std::string& id, const std::deque<std::shared_ptr<session_t>>& pending) {
+    if(m_state != states::running) {
+        for(auto it = pending.begin(); it != pending.end(); ++it) {
+            (*it)->upstream->error(resource_error, "engine is shutting down");
+            (*it)->upstream->close();
+        }
+
+        return;
+    }
+
+    std::deque<std::shared_ptr<session_t>> sessions;
+
+    for(auto it = pending.begin(); it != pending.end(); ++it) {
+        if(++(*it)->requeues > requeue_limit) {
+            (*it)->upstream->error(resource_error, "the session has failed to start too many times");
+            (*it)->upstream->close();
+        } else {
+            sessions.push_back(*it);
+        }
+    }
+
+    if(sessions.empty()) {
+        return;
+    }
+
+    COCAINE_LOG_DEBUG(
+        m_log,
+        "rescheduling %llu unstarted %s of slave %s",
+        sessions.size(),
+        sessions.size() == 1 ? "session" : "sessions",
+        id
+    );
+
+    std::shared_ptr<slave_t> slave;
+
+    {
+        std::lock_guard<session_queue_t> queue_guard(m_queue);
+
+        const auto now = session_t::clock_type::now();
+
+        // NOTE: The sessions are put in front of the queue in their original order, as they have
+        // already waited for their turn once.
+        for(auto it = sessions.rbegin(); it != sessions.rend(); ++it) {
+            if(!(*it)->pinned) {
+                (*it)->queuestamp = now;
+                m_queue.push_front(*it);
+            }
+        }
+    }
+
+    for(auto it = sessions.begin(); it != sessions.end(); ++it) {
+        if(!(*it)->pinned) {
+            continue;
+        }
+
+        // Pinned sessions are given to a new slave dedicated to the same tag, which is the same as
+        // the terminated slave ID.
+        if(!slave) {
+            if(m_pool.size() >= m_profile.pool_limit) {
+                (*it)->upstream->error(resource_error, "the pool is full");
+                (*it)->upstream->close();
+                continue;
+            }
+
+            slave = std::make_shared<slave_t>(m_context, *m_reactor, m_manifest, m_profile, id, *this);
+
+            m_pool.insert(std::make_pair(id, slave));
+        }
+
+        slave->assign(*it);
+    }
+}
+
 void
 engine_t::pump() {
     session_queue_t::value_type session;
@@ -450,9 +846,7 @@ engine_t::pump() {
     while(!m_queue.empty()) {
         std::lock_guard<std::mutex> pool_guard(m_pool_mutex);
 
-        const auto it = min_element_if(m_pool.begin(), m_pool.end(), load(), available {
-            m_profile.concurrency
-        });
+        const auto it = min_element_if(m_pool.begin(), m_pool.end(), load(), available());
 
         if(it == m_pool.end()) {
             return;
@@ -466,10 +860,7 @@ engine_t::pump() {
             }
 
             // Move out a new session from the queue.
-            session = std::move(m_queue.front());
-
-            // Destroy an empty session husk.
-            m_queue.pop_front();
+            session = m_queue.pop();
         }
 
         // Process the queue head outside the lock, because it might take some considerable amount
@@ -482,19 +873,27 @@ void
 engine_t::balance() {
     std::lock_guard<std::mutex> pool_guard(m_pool_mutex);
 
-    if(m_pool.size() >= m_profile.pool_limit ||
-       m_pool.size() * m_profile.grow_threshold >= m_queue.size())
-    {
+    if(m_pool.size() >= m_profile.pool_limit) {
         return;
     }
 
-    const unsigned int target = std::min(
-        m_profile.pool_limit,
-        std::max(
-            1UL,
-            m_queue.size() / m_profile.grow_threshold
-        )
-    );
+    unsigned int target = 0;
+
+    if(m_pool.size() * m_profile.grow_threshold < m_queue.size()) {
+        target = std::min(
+            m_profile.pool_limit,
+            std::max(
+                1UL,
+                m_queue.size() / m_profile.grow_threshold
+            )
+        );
+    }
+
+    // NOTE: The queue-based target above reacts to instantaneous bursts, while the autoscaler
+    // provisions the pool for the sustained load, so the pool is grown to the larger of the two.
+    if(m_autoscaler) {
+        target = std::max<unsigned int>(target, m_autoscaler->target());
+    }
 
     if(target <= m_pool.size()) {
         return;
@@ -515,6 +914,8 @@ engine_t::balance() {
                 id,
                 std::make_shared<slave_t>(m_context, *m_reactor, m_manifest, m_profile, id, *this)
             ));
+
+            m_ring.insert(id);
         } catch(const std::system_error& e) {
             COCAINE_LOG_ERROR(m_log, "unable to spawn more slaves - [%d] %s", e.code().value(), e.code().message());
             break;
@@ -528,6 +929,109 @@ engine_t::balance() {
     }
 }
 
+namespace {
+
+struct older {
+    template<class T>
+    bool
+    operator()(const T& lhs, const T& rhs) const {
+        return lhs->birthstamp < rhs->birthstamp;
+    }
+};
+
+} // namespace
+
+void
+engine_t::on_steal(ev::timer&, int) {
+    using namespace std::chrono;
+
+    if(m_state != states::running) {
+        return;
+    }
+
+    const auto threshold = session_queue_t::clock_type::now() - duration_cast<session_queue_t::clock_type::duration>(
+        duration<double>(m_profile.steal_threshold)
+    );
+
+    std::vector<std::shared_ptr<session_t>> stolen;
+
+    {
+        std::lock_guard<std::mutex> pool_guard(m_pool_mutex);
+
+        for(auto it = m_pool.begin(); it != m_pool.end(); ++it) {
+            const auto sessions = it->second->steal(threshold);
+            stolen.insert(stolen.end(), sessions.begin(), sessions.end());
+        }
+    }
+
+    if(stolen.empty()) {
+        return;
+    }
+
+    COCAINE_LOG_DEBUG(
+        m_log,
+        "redistributing %llu stalled %s",
+        stolen.size(),
+        stolen.size() == 1 ? "session" : "sessions"
+    );
+
+    std::sort(stolen.begin(), stolen.end(), older());
+
+    {
+        std::lock_guard<session_queue_t> queue_guard(m_queue);
+
+        const auto now = session_t::clock_type::now();
+
+        // The oldest sessions end up at the very front of the queue.
+        for(auto it = stolen.rbegin(); it != stolen.rend(); ++it) {
+            (*it)->queuestamp = now;
+            m_queue.push_front(*it);
+        }
+    }
+
+    m_stolen += stolen.size();
+
+    wake();
+}
+
+void
+engine_t::on_autoscaling(ev::timer&, int) {
+    if(m_state != states::running) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> pool_guard(m_pool_mutex);
+
+    const size_t running = std::count_if(m_pool.begin(), m_pool.end(), active());
+
+    switch(m_autoscaler->update(running, m_queue.size())) {
+    case autoscaler_t::decisions::grow:
+        // The pool will be enlarged by the balancer.
+        wake();
+        break;
+
+    case autoscaler_t::decisions::shrink: {
+        // NOTE: Retire at most one idle slave per interval, busy slaves are never interrupted.
+        const auto it = std::find_if(m_pool.begin(), m_pool.end(), idle());
+
+        if(it != m_pool.end()) {
+            COCAINE_LOG_INFO(
+                m_log,
+                "shrinking the pool from %d to %d slaves, target: %d",
+                running,
+                running - 1,
+                m_autoscaler->target()
+            );
+
+            it->second->stop();
+        }
+    } break;
+
+    case autoscaler_t::decisions::hold:
+        break;
+    }
+}
+
 void
 engine_t::migrate(states target) {
     std::lock_guard<session_queue_t> queue_guard(m_queue);
@@ -549,6 +1053,8 @@ engine_t::migrate(states target) {
                 "engine is shutting down"
             );
 
+            m_queue.front()->upstream->close();
+
             m_queue.pop_front();
         }
     }
@@ -583,16 +1089,102 @@ engine_t::migrate(states target) {
     }
 }
 
+void
+engine_t::publish() {
+    dynamic_t::object_t info;
+
+    {
+        std::lock_guard<std::mutex> pool_guard(m_pool_mutex);
+
+        collector_t collector;
+
+        size_t active = std::count_if(
+            m_pool.begin(),
+            m_pool.end(),
+            std::bind<bool>(std::ref(collector), _1)
+        );
+
+        info["load-median"] = dynamic_t::uint_t(collector.median());
+
+        info["queue"] = dynamic_t::object_t({
+            {"capacity", dynamic_t::uint_t(m_profile.queue_limit)},
+            {"depth", dynamic_t::uint_t(m_queue.size())},
+            {"stolen", dynamic_t::uint_t(m_stolen.load())}
+        });
+
+        if(m_profile.shedding.enabled) {
+            std::lock_guard<session_queue_t> queue_guard(m_queue);
+
+            info["shedding"] = dynamic_t::object_t({
+                {"active", m_queue.shedding()},
+                {"rejected", dynamic_t::uint_t(m_queue.shed())}
+            });
+        }
+
+        info["sessions"] = dynamic_t::object_t({
+            {"pending", dynamic_t::uint_t(collector.sum())}
+        });
+
+        m_load_depth.store(m_queue.size(), std::memory_order_relaxed);
+        m_load_active.store(active, std::memory_order_relaxed);
+
+        info["slaves"] = dynamic_t::object_t({
+            {"active", dynamic_t::uint_t(active)},
+            {"capacity", dynamic_t::uint_t(m_profile.pool_limit)},
+            {"idle", dynamic_t::uint_t(m_pool.size() - active)}
+        });
+
+        info["state"] = std::string(describe[static_cast<int>(m_state)]);
+
+        if(m_autoscaler) {
+            info["autoscaling"] = m_autoscaler->info();
+        }
+
+        if(m_cache) {
+            info["cache"] = m_cache->info();
+        }
+
+        dynamic_t::object_t events;
+
+        for(auto it = m_statistics.begin(); it != m_statistics.end(); ++it) {
+            events[it->first] = it->second->info();
+        }
+
+        info["events"] = events;
+
+        dynamic_t::object_t pool;
+
+        for(auto it = m_pool.begin(); it != m_pool.end(); ++it) {
+            pool[it->first] = dynamic_t::object_t({
+                {"limit", dynamic_t::uint_t(it->second->limit())},
+                {"load", dynamic_t::uint_t(it->second->load())},
+                {"utilization", it->second->utilization()}
+            });
+        }
+
+        info["pool"] = pool;
+    }
+
+    // NOTE: The report is immutable once published, so the readers can safely share it without
+    // any further synchronization.
+    m_report.store(std::make_shared<const dynamic_t>(info));
+}
+
 void
 engine_t::stop() {
     m_termination_timer->stop();
+    m_autoscaling_timer->stop();
+    m_steal_timer->stop();
 
     // NOTE: This will force the slave pool termination.
     m_pool.clear();
+    m_ring.clear();
 
     if(m_state == states::stopping) {
         m_state = states::stopped;
 
+        m_report_timer->stop();
+
         // Don't stop the event loop if the engine is becoming broken.
         m_reactor->stop();
     }
@@ -0,0 +1,143 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/detail/services/node/histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cocaine;
+using namespace cocaine::engine;
+
+histogram_t::histogram_t():
+    m_count(0),
+    m_sum(0),
+    m_max(0)
+{
+    for(auto it = m_buckets.begin(); it != m_buckets.end(); ++it) {
+        it->store(0, std::memory_order_relaxed);
+    }
+}
+
+void
+histogram_t::record(uint64_t value) {
+    m_buckets[index(value)].fetch_add(1, std::memory_order_relaxed);
+
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+
+    while(value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        // Empty.
+    }
+}
+
+uint64_t
+histogram_t::count() const {
+    return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t
+histogram_t::percentile(double quantile) const {
+    // NOTE: The buckets are summed up instead of using the total counter, so that the walk below is
+    // guaranteed to terminate even if the histogram is being updated concurrently.
+    uint64_t total = 0;
+
+    for(auto it = m_buckets.begin(); it != m_buckets.end(); ++it) {
+        total += it->load(std::memory_order_relaxed);
+    }
+
+    if(total == 0) {
+        return 0;
+    }
+
+    const uint64_t rank = std::max<uint64_t>(1, std::ceil(quantile * total));
+
+    uint64_t seen = 0;
+
+    for(unsigned i = 0; i < buckets; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+
+        if(seen >= rank) {
+            return std::min(value(i), m_max.load(std::memory_order_relaxed));
+        }
+    }
+
+    return m_max.load(std::memory_order_relaxed);
+}
+
+dynamic_t
+histogram_t::info() const {
+    dynamic_t::object_t info;
+
+    const uint64_t count = m_count.load(std::memory_order_relaxed);
+
+    info["count"] = dynamic_t::uint_t(count);
+    info["max"] = dynamic_t::uint_t(m_max.load(std::memory_order_relaxed));
+    info["mean"] = count ? double(m_sum.load(std::memory_order_relaxed)) / count : 0.0;
+
+    info["p50"] = dynamic_t::uint_t(percentile(0.5));
+    info["p90"] = dynamic_t::uint_t(percentile(0.9));
+    info["p99"] = dynamic_t::uint_t(percentile(0.99));
+    info["p999"] = dynamic_t::uint_t(percentile(0.999));
+
+    return info;
+}
+
+unsigned
+histogram_t::index(uint64_t value) {
+    if(value < sub_buckets) {
+        return value;
+    }
+
+    value = std::min<uint64_t>(value, (1ULL << magnitude) - 1);
+
+    // Position of the highest bit set, at least the precision.
+    const unsigned exponent = 63 - __builtin_clzll(value);
+    const unsigned shift = exponent - precision;
+
+    return (shift + 1) * sub_buckets + ((value >> shift) - sub_buckets);
+}
+
+uint64_t
+histogram_t::value(unsigned index) {
+    if(index < sub_buckets) {
+        return index;
+    }
+
+    const unsigned shift = index / sub_buckets - 1;
+    const uint64_t mantissa = index % sub_buckets + sub_buckets;
+
+    // The highest value which falls into the same bucket.
+    return ((mantissa + 1) << shift) - 1;
+}
+
+dynamic_t
+event_statistics_t::info() const {
+    dynamic_t::object_t info;
+
+    info["duration"] = duration.info();
+    info["first-chunk"] = first_chunk.info();
+    info["queue-wait"] = queue_wait.info();
+    info["response-size"] = response_size.info();
+
+    return info;
+}
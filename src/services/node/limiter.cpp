@@ -0,0 +1,98 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cocaine/detail/services/node/limiter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cocaine::engine;
+
+namespace {
+
+// The baseline is re-estimated periodically, so that it follows the changes in the workload.
+const size_t baseline_lifetime = 64;
+
+// The limit is never cut more than by half at once.
+const double max_backoff = 0.5;
+
+} // namespace
+
+limiter_t::limiter_t(size_t min, size_t max, double tolerance):
+    m_min(min),
+    m_max(max),
+    m_tolerance(tolerance),
+    m_limit(min),
+    m_samples(0),
+    m_latency_sum(0.0),
+    m_latency_min(std::numeric_limits<double>::max()),
+    m_saturated(false),
+    m_baseline(0.0),
+    m_baseline_age(0)
+{ }
+
+void
+limiter_t::update(double latency, size_t load) {
+    const size_t limit = m_limit.load(std::memory_order_relaxed);
+
+    if(m_min == m_max) {
+        return;
+    }
+
+    m_samples++;
+    m_latency_sum += latency;
+    m_latency_min  = std::min(m_latency_min, latency);
+    m_saturated   |= load >= limit;
+
+    // A window spans as many completions as there are sessions allowed in progress.
+    if(m_samples < limit) {
+        return;
+    }
+
+    if(m_baseline == 0.0 || m_baseline_age >= baseline_lifetime) {
+        m_baseline = m_latency_min;
+        m_baseline_age = 0;
+    } else {
+        m_baseline = std::min(m_baseline, m_latency_min);
+        m_baseline_age++;
+    }
+
+    const double mean = m_latency_sum / m_samples;
+
+    size_t target = limit;
+
+    if(mean <= m_baseline * m_tolerance) {
+        // NOTE: The limit is only grown if it was the actual bottleneck, otherwise a lightly loaded
+        // slave would have its limit inflated without any evidence that it can handle it.
+        if(m_saturated) {
+            target = limit + 1;
+        }
+    } else {
+        target = std::floor(limit * std::max(max_backoff, m_baseline * m_tolerance / mean));
+    }
+
+    m_limit.store(std::max(m_min, std::min(m_max, target)), std::memory_order_relaxed);
+
+    m_samples = 0;
+    m_latency_sum = 0.0;
+    m_latency_min = std::numeric_limits<double>::max();
+    m_saturated = false;
+}
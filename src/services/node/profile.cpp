@@ -33,6 +33,8 @@ profile_t::profile_t(context_t& context, const std::string& name_):
     idle_timeout        = as_object().at("idle-timeout", defaults::idle_timeout).to<double>();
     startup_timeout     = as_object().at("startup-timeout", defaults::startup_timeout).to<double>();
     termination_timeout = as_object().at("termination-timeout", defaults::termination_timeout).to<double>();
+    report_interval     = as_object().at("report-interval", defaults::report_interval).to<double>();
+    steal_threshold     = as_object().at("steal-threshold", defaults::steal_threshold).to<double>();
     concurrency         = as_object().at("concurrency", defaults::concurrency).to<uint64_t>();
     crashlog_limit      = as_object().at("crashlog-limit", defaults::crashlog_limit).to<uint64_t>();
     pool_limit          = as_object().at("pool-limit", defaults::pool_limit).to<uint64_t>();
@@ -42,6 +44,75 @@ profile_t::profile_t(context_t& context, const std::string& name_):
 
     grow_threshold      = as_object().at("grow-threshold", default_threshold).to<uint64_t>();
 
+    // Adaptive concurrency
+
+    const auto& adaptive_config = as_object().at("adaptive-concurrency", dynamic_t::empty_object).as_object();
+
+    adaptive_concurrency.enabled   = as_object().count("adaptive-concurrency") != 0;
+    adaptive_concurrency.min       = adaptive_config.at("min", 1UL).to<uint64_t>();
+    adaptive_concurrency.tolerance = adaptive_config.at("tolerance", defaults::concurrency_tolerance).to<double>();
+
+    // Caching
+
+    const auto& cache_config = as_object().at("cache", dynamic_t::empty_object).as_object();
+    const auto& cache_events = cache_config.at("events", dynamic_t::empty_object).as_object();
+
+    cache.size       = cache_config.at("size", defaults::cache_size).to<uint64_t>();
+    cache.body_limit = cache_config.at("body-limit", defaults::cache_body_limit).to<uint64_t>();
+
+    for(auto it = cache_events.begin(); it != cache_events.end(); ++it) {
+        cache.events[it->first] = it->second.to<double>();
+
+        if(cache.events[it->first] <= 0.0f) {
+            throw cocaine::error_t("cached event '%s' TTL must be positive", it->first);
+        }
+    }
+
+    // Coalescing
+
+    const auto& coalesce_events = as_object().at("coalesce", dynamic_t::empty_array).as_array();
+
+    for(auto it = coalesce_events.begin(); it != coalesce_events.end(); ++it) {
+        coalesce.insert(it->as_string());
+    }
+
+    // Shared memory
+
+    shared_memory           = as_object().at("shared-memory", 0UL).to<uint64_t>();
+    shared_memory_threshold = as_object().at("shared-memory-threshold", defaults::shared_memory_threshold).to<uint64_t>();
+
+    // Tag affinity
+
+    const auto affinity = as_object().at("affinity", "dedicated").as_string();
+
+    if(affinity != "dedicated" && affinity != "hashed") {
+        throw cocaine::error_t("tag affinity must be either 'dedicated' or 'hashed'");
+    }
+
+    hashed_affinity = affinity == "hashed";
+
+    // Engine thread CPU set
+
+    cpu_affinity = affinity_t(as_object().at("cpu-affinity", "").as_string());
+
+    // Autoscaling
+
+    const auto& autoscaling_config = as_object().at("autoscaling", dynamic_t::empty_object).as_object();
+
+    autoscaling.enabled     = as_object().count("autoscaling") != 0;
+    autoscaling.interval    = autoscaling_config.at("interval", defaults::autoscaling_interval).to<double>();
+    autoscaling.window      = autoscaling_config.at("window", defaults::autoscaling_window).to<double>();
+    autoscaling.utilization = autoscaling_config.at("utilization", defaults::autoscaling_utilization).to<double>();
+    autoscaling.cooldown    = autoscaling_config.at("cooldown", defaults::autoscaling_cooldown).to<double>();
+
+    // Load shedding
+
+    const auto& shedding_config = as_object().at("shedding", dynamic_t::empty_object).as_object();
+
+    shedding.enabled  = as_object().count("shedding") != 0;
+    shedding.target   = shedding_config.at("target", defaults::shedding_target).to<double>();
+    shedding.interval = shedding_config.at("interval", defaults::shedding_interval).to<double>();
+
     // Isolation
 
     const auto& isolate_config = as_object().at("isolate", dynamic_t::empty_object).as_object();
@@ -57,6 +128,14 @@ profile_t::profile_t(context_t& context, const std::string& name_):
         throw cocaine::error_t("slave heartbeat timeout must be positive");
     }
 
+    if(steal_threshold < 0.0f) {
+        throw cocaine::error_t("session steal threshold must be non-negative");
+    }
+
+    if(report_interval <= 0.0f) {
+        throw cocaine::error_t("engine report interval must be positive");
+    }
+
     if(idle_timeout < 0.0f) {
         throw cocaine::error_t("slave idle timeout must non-negative");
     }
@@ -76,5 +155,33 @@ profile_t::profile_t(context_t& context, const std::string& name_):
     if(concurrency == 0) {
         throw cocaine::error_t("engine concurrency must be positive");
     }
+
+    if(adaptive_concurrency.min == 0 || adaptive_concurrency.min > concurrency) {
+        throw cocaine::error_t("adaptive concurrency lower bound must be in the [1, concurrency] range");
+    }
+
+    if(adaptive_concurrency.tolerance < 1.0f) {
+        throw cocaine::error_t("adaptive concurrency tolerance must be at least 1");
+    }
+
+    if(shared_memory && shared_memory < shared_memory_threshold) {
+        throw cocaine::error_t("shared memory ring must be able to fit at least a single chunk");
+    }
+
+    if(autoscaling.interval <= 0.0f || autoscaling.window <= 0.0f) {
+        throw cocaine::error_t("autoscaling interval and window must be positive");
+    }
+
+    if(autoscaling.utilization <= 0.0f || autoscaling.utilization > 1.0f) {
+        throw cocaine::error_t("autoscaling utilization must be in the (0, 1] range");
+    }
+
+    if(autoscaling.cooldown < 0.0f) {
+        throw cocaine::error_t("autoscaling cooldown must be non-negative");
+    }
+
+    if(shedding.target <= 0.0f || shedding.interval <= 0.0f) {
+        throw cocaine::error_t("load shedding target and interval must be positive");
+    }
 }
 
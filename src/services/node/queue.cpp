@@ -23,11 +23,85 @@
 
 using namespace cocaine::engine;
 
+session_queue_t::session_queue_t():
+    m_target(clock_type::duration::zero()),
+    m_interval(clock_type::duration::zero()),
+    m_min_delay(clock_type::duration::max()),
+    m_overloaded(false),
+    m_shed(0)
+{ }
+
 void
 session_queue_t::push(const_reference session) {
+    session->queuestamp = clock_type::now();
+
     if(session->event.policy.urgent) {
         emplace_front(session);
     } else {
         emplace_back(session);
     }
 }
+
+session_queue_t::value_type
+session_queue_t::pop() {
+    value_type session = std::move(front());
+
+    pop_front();
+
+    // NOTE: Urgent sessions skip the queue, so their wait time says nothing about the standing
+    // delay and would only hide it.
+    if(m_target != clock_type::duration::zero() && !session->event.policy.urgent) {
+        const auto now = clock_type::now();
+
+        // NOTE: An empty queue means there's no standing delay, whatever the head has waited for.
+        sample(now, empty() ? clock_type::duration::zero() : now - session->queuestamp);
+    }
+
+    return session;
+}
+
+void
+session_queue_t::control(double target, double interval) {
+    using namespace std::chrono;
+
+    m_target = duration_cast<clock_type::duration>(duration<double>(target));
+    m_interval = duration_cast<clock_type::duration>(duration<double>(interval));
+
+    m_interval_end = clock_type::now() + m_interval;
+}
+
+bool
+session_queue_t::admit() {
+    if(m_target == clock_type::duration::zero() || !m_overloaded) {
+        return true;
+    }
+
+    // NOTE: The overload verdict is only refreshed on dequeue. Without any dequeues for a whole
+    // interval there's nothing to base it on, and an empty queue has no standing delay at all, so
+    // the sessions are admitted again, otherwise nothing would ever be dequeued to refresh it. The
+    // queue limit still bounds the queue if it's not drained.
+    if(empty() || clock_type::now() >= m_interval_end + m_interval) {
+        m_overloaded = false;
+        return true;
+    }
+
+    m_shed++;
+
+    return false;
+}
+
+void
+session_queue_t::sample(clock_type::time_point now, clock_type::duration sojourn) {
+    if(sojourn < m_min_delay) {
+        m_min_delay = sojourn;
+    }
+
+    if(now < m_interval_end) {
+        return;
+    }
+
+    m_overloaded = m_min_delay > m_target;
+
+    m_min_delay = clock_type::duration::max();
+    m_interval_end = now + m_interval;
+}
@@ -0,0 +1,57 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cocaine/detail/services/node/ring.hpp"
+
+#include <boost/lexical_cast.hpp>
+
+using namespace cocaine::engine;
+
+namespace {
+
+// Number of ring points per member.
+const unsigned int replicas = 64;
+
+} // namespace
+
+void
+hash_ring_t::insert(const std::string& id) {
+    for(unsigned int i = 0; i < replicas; ++i) {
+        m_ring.insert(std::make_pair(m_hash(id + "#" + boost::lexical_cast<std::string>(i)), id));
+    }
+}
+
+void
+hash_ring_t::erase(const std::string& id) {
+    for(unsigned int i = 0; i < replicas; ++i) {
+        ring_map_t::iterator it = m_ring.find(m_hash(id + "#" + boost::lexical_cast<std::string>(i)));
+
+        // NOTE: The point might be owned by some other member in case of a hash collision.
+        if(it != m_ring.end() && it->second == id) {
+            m_ring.erase(it);
+        }
+    }
+}
+
+void
+hash_ring_t::clear() {
+    m_ring.clear();
+}
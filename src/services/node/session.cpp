@@ -20,6 +20,7 @@
 
 #include "cocaine/detail/services/node/session.hpp"
 #include "cocaine/detail/services/node/messages.hpp"
+#include "cocaine/detail/services/node/shared_ring.hpp"
 
 #include "cocaine/traits/literal.hpp"
 
@@ -30,6 +31,12 @@ session_t::session_t(uint64_t id_, const api::event_t& event_, const api::stream
     id(id_),
     event(event_),
     upstream(upstream_),
+    pinned(false),
+    requeues(0),
+    birthstamp(clock_type::now()),
+    queuestamp(birthstamp),
+    reply_size(0),
+    m_threshold(0),
     m_state(state::open)
 {
     m_encoder.reset(new encoder<writable_stream<io::socket<local>>>());
@@ -40,10 +47,54 @@ session_t::session_t(uint64_t id_, const api::event_t& event_, const api::stream
 
 void
 session_t::attach(const std::shared_ptr<writable_stream<io::socket<local>>>& downstream) {
+    attachstamp = clock_type::now();
+
     // Flush all the cached messages into the downstream.
     m_encoder->attach(downstream);
 }
 
+void
+session_t::attach(const std::shared_ptr<writable_stream<io::socket<local>>>& downstream,
+                  const std::shared_ptr<shared_ring_t>& ring,
+                  size_t threshold)
+{
+    attach(downstream);
+
+    // NOTE: The ring is enabled only after the cached messages are flushed, otherwise their chunk
+    // positions could get into the channel out of the ring order.
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_ring = ring;
+    m_threshold = threshold;
+}
+
+void
+session_t::write(const char* chunk, size_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(m_state != state::open) {
+        throw cocaine::error_t("the session is no longer valid");
+    }
+
+    if(m_ring && size >= m_threshold) {
+        // NOTE: The ring is shared by all the slave sessions, and the slave releases the ring space
+        // in the order the chunks arrive, so the ring is kept locked until the chunk position is
+        // written into the channel.
+        std::lock_guard<shared_ring_t> guard(*m_ring);
+
+        uint64_t offset = 0;
+
+        if(m_ring->write(chunk, size, offset)) {
+            m_encoder->write<rpc::mapped_chunk>(id, offset, size);
+            return;
+        }
+
+        // The ring is full, fall back to the regular channel.
+    }
+
+    m_encoder->write<rpc::chunk>(id, literal_t { chunk, size });
+}
+
 void
 session_t::detach() {
     close();
@@ -74,7 +125,7 @@ session_t::downstream_t::~downstream_t() {
 
 void
 session_t::downstream_t::write(const char* chunk, size_t size) {
-    parent->send<rpc::chunk>(literal_t { chunk, size });
+    parent->write(chunk, size);
 }
 
 void
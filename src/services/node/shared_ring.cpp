@@ -0,0 +1,142 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cocaine/detail/services/node/shared_ring.hpp"
+
+#include "cocaine/detail/atomic.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+    #define MFD_CLOEXEC 0x0001U
+#endif
+
+using namespace cocaine::engine;
+
+struct shared_ring_t::header_t {
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+};
+
+namespace {
+
+int
+create(const char* name) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    return ::syscall(SYS_memfd_create, name, MFD_CLOEXEC);
+#else
+    (void)name;
+
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+} // namespace
+
+shared_ring_t::shared_ring_t(size_t capacity):
+    m_capacity(capacity)
+{
+    if((m_fd = create("cocaine")) == -1) {
+        throw std::system_error(errno, std::system_category(), "unable to create a shared memory file");
+    }
+
+    const size_t size = sizeof(header_t) + m_capacity;
+
+    if(::ftruncate(m_fd, size) != 0) {
+        const int ec = errno;
+        ::close(m_fd);
+        throw std::system_error(ec, std::system_category(), "unable to resize a shared memory file");
+    }
+
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+
+    if(memory == MAP_FAILED) {
+        const int ec = errno;
+        ::close(m_fd);
+        throw std::system_error(ec, std::system_category(), "unable to map a shared memory file");
+    }
+
+    m_header = new(memory) header_t();
+    m_data = static_cast<char*>(memory) + sizeof(header_t);
+
+    m_header->head = 0;
+    m_header->tail = 0;
+}
+
+shared_ring_t::~shared_ring_t() {
+    ::munmap(m_header, sizeof(header_t) + m_capacity);
+    ::close(m_fd);
+}
+
+bool
+shared_ring_t::write(const char* data, size_t size, uint64_t& offset) {
+    const uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+
+    offset = head;
+
+    if(head % m_capacity + size > m_capacity) {
+        // Skip the ring tail, so that the payload stays contiguous.
+        offset += m_capacity - head % m_capacity;
+    }
+
+    if(offset + size - tail > m_capacity) {
+        return false;
+    }
+
+    std::memcpy(m_data + offset % m_capacity, data, size);
+
+    m_header->head.store(offset + size, std::memory_order_release);
+
+    return true;
+}
+
+const char*
+shared_ring_t::read(uint64_t offset, size_t size) const {
+    const uint64_t head = m_header->head.load(std::memory_order_acquire);
+    const uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+
+    // NOTE: The positions come from the other side, as well as the head, so they are checked to
+    // point inside the ring region which is actually occupied by the producer. No sums are used in
+    // the checks, so that crafted values can't wrap around.
+    if(size > m_capacity || offset < tail || offset > head || size > head - offset) {
+        return nullptr;
+    }
+
+    if(offset % m_capacity > m_capacity - size) {
+        return nullptr;
+    }
+
+    return m_data + offset % m_capacity;
+}
+
+void
+shared_ring_t::release(uint64_t offset, size_t size) {
+    m_header->tail.store(offset + size, std::memory_order_release);
+}
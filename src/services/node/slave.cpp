@@ -30,6 +30,7 @@
 #include "cocaine/detail/services/node/messages.hpp"
 #include "cocaine/detail/services/node/profile.hpp"
 #include "cocaine/detail/services/node/session.hpp"
+#include "cocaine/detail/services/node/shared_ring.hpp"
 #include "cocaine/detail/services/node/stream.hpp"
 
 #include "cocaine/logging.hpp"
@@ -39,11 +40,13 @@
 #include "cocaine/traits/enum.hpp"
 #include "cocaine/traits/literal.hpp"
 
-#include <sstream>
+#include <cstring>
+#include <deque>
 
 #include <boost/lexical_cast.hpp>
 
 #include <fcntl.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 using namespace cocaine;
@@ -90,6 +93,10 @@ struct ignore {
     }
 };
 
+// NOTE: The crashlog limit is specified in lines, while the output is captured into a byte ring,
+// which is sized to fit that many lines of a reasonable length.
+const size_t average_line_length = 1024;
+
 } // namespace
 
 slave_t::slave_t(context_t& context, reactor_t& reactor, const manifest_t& manifest, const profile_t& profile, const std::string& id, engine_t& engine):
@@ -101,14 +108,16 @@ slave_t::slave_t(context_t& context, reactor_t& reactor, const manifest_t& manif
     m_id(id),
     m_engine(engine),
     m_state(states::unknown),
-#if defined(__clang__) || defined(HAVE_GCC47)
-    m_birthstamp(std::chrono::steady_clock::now()),
-#else
-    m_birthstamp(std::chrono::monotonic_clock::now()),
-#endif
+    m_birthstamp(clock_type::now()),
+    m_busy_time(clock_type::duration::zero()),
     m_heartbeat_timer(new ev::timer(reactor.native())),
     m_idle_timer(new ev::timer(reactor.native())),
-    m_output_ring(profile.crashlog_limit)
+    m_output_ring(profile.crashlog_limit * average_line_length),
+    m_limiter(
+        profile.adaptive_concurrency.enabled ? profile.adaptive_concurrency.min : profile.concurrency,
+        profile.concurrency,
+        profile.adaptive_concurrency.tolerance
+    )
 {
     reactor.update();
 
@@ -186,6 +195,87 @@ slave_t::bind(const std::shared_ptr<channel<io::socket<local>>>& channel_) {
     );
 }
 
+void
+slave_t::share(int fd) {
+    BOOST_ASSERT(m_channel);
+
+    try {
+        m_tx_ring = std::make_shared<shared_ring_t>(m_profile.shared_memory);
+        m_rx_ring.reset(new shared_ring_t(m_profile.shared_memory));
+    } catch(const std::system_error& e) {
+        COCAINE_LOG_WARNING(
+            m_log,
+            "slave %s is unable to use shared memory - [%d] %s",
+            m_id,
+            e.code().value(),
+            e.code().message()
+        );
+
+        m_tx_ring.reset();
+        m_rx_ring.reset();
+
+        return;
+    }
+
+    msgpack::sbuffer buffer;
+    msgpack::packer<msgpack::sbuffer> packer(buffer);
+
+    packer.pack_array(3);
+    packer.pack_uint64(0);
+    packer.pack_uint32(event_traits<rpc::mapping>::id);
+
+    type_traits<event_traits<rpc::mapping>::tuple_type>::pack(
+        packer,
+        m_profile.shared_memory,
+        m_profile.shared_memory_threshold
+    );
+
+    struct iovec io = { const_cast<char*>(buffer.data()), buffer.size() };
+
+    const int rings[] = { m_tx_ring->fd(), m_rx_ring->fd() };
+
+    union {
+        struct cmsghdr header;
+        char data[CMSG_SPACE(sizeof(rings))];
+    } control;
+
+    struct msghdr message;
+
+    std::memset(&message, 0, sizeof(message));
+
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data;
+    message.msg_controllen = sizeof(control.data);
+
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(rings));
+
+    std::memcpy(CMSG_DATA(header), rings, sizeof(rings));
+
+    // NOTE: Nothing has been written into the channel right after the handshake, so the message
+    // can be sent directly into the socket without breaking the message order. The message is tiny
+    // and the socket buffer is empty, so it's never sent partially.
+    if(::sendmsg(fd, &message, 0) != static_cast<ssize_t>(buffer.size())) {
+        COCAINE_LOG_WARNING(m_log, "slave %s is unable to receive the shared memory rings", m_id);
+
+        m_tx_ring.reset();
+        m_rx_ring.reset();
+
+        return;
+    }
+
+    COCAINE_LOG_DEBUG(
+        m_log,
+        "slave %s is using shared memory rings, capacity: %llu bytes",
+        m_id,
+        m_profile.shared_memory
+    );
+}
+
 void
 slave_t::assign(const std::shared_ptr<session_t>& session) {
     BOOST_ASSERT(m_state != states::inactive);
@@ -200,12 +290,15 @@ slave_t::assign(const std::shared_ptr<session_t>& session) {
             "the session has expired in the queue"
         );
 
+        session->upstream->close();
+
         return;
     }
 
     std::unique_lock<std::mutex> lock(m_mutex);
 
-    if(m_sessions.size() >= m_profile.concurrency || m_state == states::unknown) {
+    if(m_sessions.size() >= m_limiter.limit() || m_state == states::unknown) {
+        session->queuestamp = session_t::clock_type::now();
         m_queue.push_back(session);
         return;
     }
@@ -214,6 +307,10 @@ slave_t::assign(const std::shared_ptr<session_t>& session) {
 
     m_idle_timer->stop();
 
+    if(m_sessions.empty()) {
+        m_busy_since = clock_type::now();
+    }
+
     m_sessions.insert(std::make_pair(session->id, session));
 
     // NOTE: Allows other sessions to be processed while this one is being attached.
@@ -221,7 +318,50 @@ slave_t::assign(const std::shared_ptr<session_t>& session) {
 
     COCAINE_LOG_DEBUG(m_log, "slave %s has started processing session %s", m_id, session->id);
 
-    session->attach(m_channel->wr->stream());
+    if(m_tx_ring) {
+        session->attach(m_channel->wr->stream(), m_tx_ring, m_profile.shared_memory_threshold);
+    } else {
+        session->attach(m_channel->wr->stream());
+    }
+
+    m_engine.started(*session);
+}
+
+std::vector<std::shared_ptr<session_t>>
+slave_t::steal(session_queue_t::clock_type::time_point threshold) {
+    std::vector<std::shared_ptr<session_t>> stolen;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    for(auto it = m_queue.begin(); it != m_queue.end();) {
+        if(!(*it)->pinned && (*it)->queuestamp < threshold) {
+            stolen.push_back(std::move(*it));
+            it = m_queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return stolen;
+}
+
+double
+slave_t::utilization() const {
+    using namespace std::chrono;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    const auto now = clock_type::now();
+
+    auto busy = m_busy_time;
+
+    if(!m_sessions.empty()) {
+        busy += now - m_busy_since;
+    }
+
+    const auto uptime = duration_cast<duration<double>>(now - m_birthstamp).count();
+
+    return uptime > 0.0 ? duration_cast<duration<double>>(busy).count() / uptime : 0.0;
 }
 
 void
@@ -230,6 +370,10 @@ slave_t::stop() {
 
     m_state = states::inactive;
 
+    // NOTE: The slave might be stopped while idle, e.g. when the pool shrinks, so the idle timer
+    // must not fire later on and deactivate it once again.
+    m_idle_timer->stop();
+
     m_channel->wr->write<rpc::terminate>(0UL, rpc::terminate::normal, "the engine is shutting down");
 }
 
@@ -260,7 +404,14 @@ slave_t::on_message(const message_t& message) {
         std::string chunk;
 
         message.as<rpc::chunk>(chunk);
-        on_chunk(message.band(), chunk);
+        on_chunk(message.band(), chunk.data(), chunk.size());
+    } break;
+
+    case event_traits<rpc::mapped_chunk>::id: {
+        uint64_t offset, size;
+
+        message.as<rpc::mapped_chunk>(offset, size);
+        on_mapped_chunk(message.band(), offset, size);
     } break;
 
     case event_traits<rpc::error>::id: {
@@ -326,11 +477,7 @@ slave_t::on_ping() {
         using namespace std::chrono;
 
         const auto uptime = duration_cast<duration<float>>(
-#if defined(__clang__) || defined(HAVE_GCC47)
-            steady_clock::now() - m_birthstamp
-#else
-            monotonic_clock::now() - m_birthstamp
-#endif
+            clock_type::now() - m_birthstamp
         );
 
         COCAINE_LOG_DEBUG(
@@ -366,7 +513,7 @@ slave_t::on_death(int code, const std::string& reason) {
 }
 
 void
-slave_t::on_chunk(uint64_t session_id, const std::string& chunk) {
+slave_t::on_chunk(uint64_t session_id, const char* chunk, size_t size) {
     BOOST_ASSERT(m_state == states::active);
 
     COCAINE_LOG_DEBUG(
@@ -374,7 +521,7 @@ slave_t::on_chunk(uint64_t session_id, const std::string& chunk) {
         "slave %s received session %d chunk, size: %llu bytes",
         m_id,
         session_id,
-        chunk.size()
+        size
     );
 
     session_map_t::iterator it;
@@ -390,7 +537,33 @@ slave_t::on_chunk(uint64_t session_id, const std::string& chunk) {
         }
     }
 
-    it->second->upstream->write(chunk.data(), chunk.size());
+    session_t& session = *it->second;
+
+    if(session.replystamp == session_t::clock_type::time_point()) {
+        session.replystamp = session_t::clock_type::now();
+    }
+
+    session.reply_size += size;
+    session.upstream->write(chunk, size);
+}
+
+void
+slave_t::on_mapped_chunk(uint64_t session_id, uint64_t offset, uint64_t size) {
+    const char* chunk = m_rx_ring ? m_rx_ring->read(offset, size) : nullptr;
+
+    if(!chunk) {
+        COCAINE_LOG_ERROR(m_log, "slave %s sent an invalid shared memory chunk reference", m_id);
+
+        dump();
+        terminate(rpc::terminate::code::normal, "slave has violated the shared memory protocol");
+
+        return;
+    }
+
+    on_chunk(session_id, chunk, size);
+
+    // The chunk has been copied into the upstream, so its ring space can be reused.
+    m_rx_ring->release(offset, size);
 }
 
 void
@@ -447,12 +620,25 @@ slave_t::on_choke(uint64_t session_id) {
 
         session = std::move(it->second);
 
+        m_limiter.update(
+            std::chrono::duration_cast<std::chrono::duration<double>>(
+                clock_type::now() - session->attachstamp
+            ).count(),
+            m_sessions.size()
+        );
+
         m_sessions.erase(it);
+
+        if(m_sessions.empty()) {
+            m_busy_time += clock_type::now() - m_busy_since;
+        }
     }
 
     session->upstream->close();
     session->detach();
 
+    m_engine.finished(*session);
+
     // Destroy the session before calling the potentially heavy queue pumps.
     session.reset();
 
@@ -493,26 +679,25 @@ slave_t::on_idle(ev::timer&, int) {
 
 size_t
 slave_t::on_output(const char* data, size_t size) {
-    std::string input(data, size),
-                line;
-
-    std::istringstream stream(input);
-
-    size_t leftovers = 0;
+    if(!m_profile.log_output) {
+        // NOTE: When the output is not logged, there's no need to split it into lines until the
+        // crashlog is actually dumped, so the whole chunk is consumed right away.
+        m_output_ring.insert(m_output_ring.end(), data, data + size);
+        return size;
+    }
 
-    while(stream) {
-        if(std::getline(stream, line)) {
-            m_output_ring.push_back(line);
+    const char* it = data;
+    const char* end = data + size;
 
-            if(m_profile.log_output) {
-                COCAINE_LOG_DEBUG(m_log, "slave %s output: %s", m_id, line);
-            }
-        } else {
-            leftovers = line.size();
-        }
+    while(const char* eol = static_cast<const char*>(std::memchr(it, '\n', end - it))) {
+        COCAINE_LOG_DEBUG(m_log, "slave %s output: %s", m_id, std::string(it, eol - it));
+        it = eol + 1;
     }
 
-    return size - leftovers;
+    // Incomplete lines are left in the stream buffer until the rest of them arrives.
+    m_output_ring.insert(m_output_ring.end(), data, it);
+
+    return it - data;
 }
 
 void
@@ -523,7 +708,7 @@ slave_t::pump() {
         {
             std::lock_guard<std::mutex> guard(m_mutex);
 
-            if(m_queue.empty() || m_sessions.size() >= m_profile.concurrency) {
+            if(m_queue.empty() || m_sessions.size() >= m_limiter.limit()) {
                 break;
             }
 
@@ -556,11 +741,25 @@ slave_t::dump() {
 
     COCAINE_LOG_INFO(m_log, "slave %s is dumping output to 'crashlogs/%s'", m_id, key);
 
-    std::vector<std::string> dump;
-    std::copy(m_output_ring.begin(), m_output_ring.end(), std::back_inserter(dump));
+    const std::string output(m_output_ring.begin(), m_output_ring.end());
+
+    std::deque<std::string> dump;
+
+    // The first line might be truncated by the ring, but it's still useful.
+    for(size_t offset = 0, eol = 0; offset < output.size(); offset = eol + 1) {
+        if((eol = output.find('\n', offset)) == std::string::npos) {
+            eol = output.size();
+        }
+
+        dump.emplace_back(output, offset, eol - offset);
+
+        if(dump.size() > m_profile.crashlog_limit) {
+            dump.pop_front();
+        }
+    }
 
     try {
-        api::storage(m_context, "core")->put("crashlogs", key, dump, std::vector<std::string> {
+        api::storage(m_context, "core")->put("crashlogs", key, std::vector<std::string>(dump.begin(), dump.end()), std::vector<std::string> {
             m_manifest.name
         });
     } catch(const storage_error_t& e) {
@@ -575,6 +774,7 @@ struct detach_with {
     void
     operator()(const T& session) const {
         session.second->upstream->error(code, message);
+        session.second->upstream->close();
         session.second->detach();
     }
 
@@ -601,5 +801,11 @@ slave_t::terminate(int code, const std::string& reason) {
         m_sessions.clear();
     }
 
-    m_reactor.post(std::bind(&engine_t::erase, std::ref(m_engine), m_id, code, reason));
+    // NOTE: Queued sessions have never been sent to the slave, so the engine can safely give them
+    // to some other slave instead of failing them.
+    std::deque<std::shared_ptr<session_t>> pending;
+
+    pending.swap(m_queue);
+
+    m_reactor.post(std::bind(&engine_t::erase, std::ref(m_engine), m_id, code, reason, pending));
 }
@@ -90,6 +90,26 @@ session_t::detach() {
     ptr.reset();
 }
 
+std::shared_ptr<io::socket<io::tcp>>
+session_t::release() {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    if(!ptr || !channels->empty()) {
+        return std::shared_ptr<io::socket<io::tcp>>();
+    }
+
+    if(ptr->rd->stream()->pending() || ptr->wr->stream()->pending()) {
+        return std::shared_ptr<io::socket<io::tcp>>();
+    }
+
+    // NOTE: The socket outlives the connection, as the reference is held by the caller.
+    auto socket = ptr->socket();
+
+    ptr.reset();
+
+    return socket;
+}
+
 void
 session_t::revoke(uint64_t index) {
     channels->erase(index);
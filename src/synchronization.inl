@@ -21,10 +21,22 @@
 #include "cocaine/traits/graph.hpp"
 #include "cocaine/traits/tuple.hpp"
 
+namespace {
+
+// Load metrics change all the time, so they are announced periodically rather than on changes.
+const float load_announce_interval = 5.0f;
+
+} // namespace
+
 struct context_t::synchronization_t:
     public basic_slot<io::locator::synchronize>
 {
     typedef result_of<io::locator::synchronize>::type result_type;
+    typedef io::streaming<result_type> protocol;
+
+    typedef std::tuple_element<2, result_type>::type dump_type;
+    typedef std::tuple_element<3, result_type>::type removed_type;
+    typedef std::tuple_element<4, result_type>::type load_type;
 
     synchronization_t(context_t& self);
 
@@ -32,6 +44,12 @@ struct context_t::synchronization_t:
     std::shared_ptr<dispatch_t>
     operator()(const msgpack::object& unpacked, const std::shared_ptr<upstream_t>& upstream);
 
+    // Starts the periodic load announces on the given reactor, which must not be running yet.
+    void
+    start(const std::shared_ptr<reactor_t>& reactor);
+
+    // Sends the changes since the previous update along with the current load to all the remote
+    // clients. The update is packed only once for all of them.
     void
     announce();
 
@@ -40,22 +58,56 @@ struct context_t::synchronization_t:
 
 private:
     auto
-    dump() const -> result_type;
+    load() const -> load_type;
+
+    void
+    on_timer(ev::timer&, int);
 
 private:
     context_t& self;
 
     // Remote clients for future updates.
     std::vector<std::shared_ptr<upstream_t>> upstreams;
+
+    // Current update version and the services as of that version, which the future deltas are
+    // computed against. Guarded by the same mutex as the clients, so that every client gets the
+    // full dump and then every single delta after it.
+    uint64_t version;
+    dump_type published;
+
+    std::mutex mutex;
+
+    std::shared_ptr<reactor_t> reactor;
+    std::unique_ptr<ev::timer> timer;
 };
 
+namespace {
+
+template<class Event, typename... Args>
+void
+pack_arguments(msgpack::sbuffer& buffer, Args&&... args) {
+    msgpack::packer<msgpack::sbuffer> packer(buffer);
+
+    type_traits<typename io::event_traits<Event>::tuple_type>::pack(packer, std::forward<Args>(args)...);
+}
+
+} // namespace
+
 context_t::synchronization_t::synchronization_t(context_t& self_):
-    self(self_)
+    self(self_),
+    version(0)
 { }
 
 std::shared_ptr<dispatch_t>
 context_t::synchronization_t::operator()(const msgpack::object& /* unpacked */, const std::shared_ptr<upstream_t>& upstream) {
-    upstream->send<io::streaming<result_type>::chunk>(dump());
+    // Bring the existing clients up to date first, so that the full dump matches the current state.
+    announce();
+
+    const load_type metrics = load();
+
+    std::lock_guard<std::mutex> guard(mutex);
+
+    upstream->send<protocol::chunk>(version, true, published, removed_type(), metrics);
 
     // Save this upstream for the future notifications.
     upstreams.push_back(upstream);
@@ -64,33 +116,105 @@ context_t::synchronization_t::operator()(const msgpack::object& /* unpacked */,
     return std::shared_ptr<dispatch_t>();
 }
 
+void
+context_t::synchronization_t::start(const std::shared_ptr<reactor_t>& reactor_) {
+    reactor = reactor_;
+
+    timer.reset(new ev::timer(reactor->native()));
+    timer->set<synchronization_t, &synchronization_t::on_timer>(this);
+    timer->start(load_announce_interval, load_announce_interval);
+}
+
 void
 context_t::synchronization_t::announce() {
-    result_type result = dump();
+    const load_type metrics = load();
+
+    std::lock_guard<std::mutex> guard(mutex);
+
+    // NOTE: The index is loaded under the lock, so that concurrent announces are serialized in the
+    // index order. Otherwise an announce with a stale index could roll the published state back.
+    const auto index = self.m_index.load();
+    const dump_type empty;
+    const dump_type& services = index ? index->metadata : empty;
+
+    dump_type added;
+    removed_type removed;
+
+    // NOTE: Both maps are ordered by the service name, so the delta is computed in a single pass.
+    dump_type::const_iterator lhs = published.begin(), rhs = services.begin();
+
+    while(lhs != published.end() || rhs != services.end()) {
+        if(rhs == services.end() || (lhs != published.end() && lhs->first < rhs->first)) {
+            removed.push_back((lhs++)->first);
+        } else if(lhs == published.end() || rhs->first < lhs->first) {
+            added.insert(*rhs++);
+        } else {
+            // Services which have been restarted with a different endpoint or protocol are sent
+            // over as new ones, the remote side will replace them.
+            if(lhs->second != rhs->second) {
+                added.insert(*rhs);
+            }
+
+            ++lhs;
+            ++rhs;
+        }
+    }
+
+    published = services;
+
+    if(upstreams.empty()) {
+        // Nobody to send the update to, but the version is still bumped to keep the deltas apart.
+        version++;
+        return;
+    }
+
+    msgpack::sbuffer buffer;
+
+    pack_arguments<protocol::chunk>(buffer, ++version, false, added, removed, metrics);
 
     for(auto it = upstreams.begin(); it != upstreams.end(); ++it) {
-        (*it)->send<io::streaming<result_type>::chunk>(result);
+        (*it)->send_packed<protocol::chunk>(buffer.data(), buffer.size());
     }
 }
 
 void
 context_t::synchronization_t::shutdown() {
+    if(timer) {
+        timer->stop();
+        timer.reset();
+    }
+
+    reactor.reset();
+
+    std::lock_guard<std::mutex> guard(mutex);
+
     for(auto it = upstreams.begin(); it != upstreams.end(); ++it) {
-        (*it)->send<io::streaming<result_type>::choke>();
+        (*it)->send<protocol::choke>();
     }
 
     upstreams.clear();
 }
 
 auto
-context_t::synchronization_t::dump() const -> result_type {
-    result_type result;
+context_t::synchronization_t::load() const -> load_type {
+    load_type result;
 
+    // NOTE: The services lock is held so that none of the services could be destroyed while their
+    // load is being queried. The metrics are cached by the services, so it doesn't take long.
     auto locked = self.m_services.synchronize();
 
     for(auto it = locked->begin(); it != locked->end(); ++it) {
-        result[it->first] = it->second->metadata();
+        const auto metrics = it->second->prototype().load();
+
+        if(metrics) {
+            result[it->first] = metrics.get();
+        }
     }
 
     return result;
 }
+
+void
+context_t::synchronization_t::on_timer(ev::timer&, int) {
+    announce();
+}
@@ -0,0 +1,179 @@
+/*
+    Copyright (c) 2011-2013 Andrey Sibiryov <me@kobology.ru>
+    Copyright (c) 2011-2013 Other contributors as noted in the AUTHORS file.
+
+    This file is part of Cocaine.
+
+    Cocaine is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Cocaine is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "cocaine/detail/workers.hpp"
+
+#include "cocaine/memory.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+
+#if defined(__linux__)
+    #include <sys/prctl.h>
+#endif
+
+using namespace cocaine;
+
+struct worker_pool_t::state_t {
+    state_t(size_t limit_):
+        limit(limit_),
+        stopped(false)
+    { }
+
+    typedef std::deque<std::pair<const void*, std::function<void()>>> task_queue_t;
+
+    // Finds the first task which doesn't have another task with the same key currently running.
+    task_queue_t::iterator
+    next() {
+        auto it = tasks.begin();
+
+        while(it != tasks.end() && it->first && running.count(it->first)) {
+            ++it;
+        }
+
+        return it;
+    }
+
+    const size_t limit;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    task_queue_t tasks;
+
+    // Keys of the tasks which are currently running.
+    std::multiset<const void*> running;
+
+    bool stopped;
+};
+
+struct worker_pool_t::worker_t {
+    void
+    operator()() const {
+#if defined(__linux__)
+        if(name.size() < 16) {
+            ::prctl(PR_SET_NAME, name.c_str());
+        } else {
+            ::prctl(PR_SET_NAME, name.substr(0, 16).data());
+        }
+#endif
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+
+        while(true) {
+            auto it = state->next();
+
+            while(!state->stopped && it == state->tasks.end()) {
+                state->condition.wait(lock);
+                it = state->next();
+            }
+
+            if(state->stopped) {
+                return;
+            }
+
+            const void* key = it->first;
+            const std::function<void()> task = std::move(it->second);
+
+            state->tasks.erase(it);
+
+            if(key) {
+                state->running.insert(key);
+            }
+
+            lock.unlock();
+
+            // NOTE: Tasks are expected to handle their own failures, there's nobody to report to.
+            try {
+                task();
+            } catch(...) {
+                // Empty.
+            }
+
+            lock.lock();
+
+            if(key) {
+                state->running.erase(state->running.find(key));
+
+                // Some other thread might be waiting for the tasks with this key to become runnable.
+                if(!state->tasks.empty()) {
+                    state->condition.notify_one();
+                }
+            }
+        }
+    }
+
+    const std::string name;
+    const std::shared_ptr<state_t> state;
+};
+
+worker_pool_t::worker_pool_t(const std::string& name, size_t size, size_t limit):
+    m_state(std::make_shared<state_t>(limit))
+{
+    while(size--) {
+        m_threads.emplace_back(std::make_unique<boost::thread>(worker_t{name, m_state}));
+    }
+}
+
+worker_pool_t::~worker_pool_t() {
+    {
+        std::lock_guard<std::mutex> guard(m_state->mutex);
+
+        m_state->stopped = true;
+        m_state->tasks.clear();
+    }
+
+    m_state->condition.notify_all();
+
+    for(auto it = m_threads.begin(); it != m_threads.end(); ++it) {
+        if((*it)->get_id() == boost::this_thread::get_id()) {
+            (*it)->detach();
+        } else {
+            (*it)->join();
+        }
+    }
+}
+
+bool
+worker_pool_t::post(const void* key, const std::function<void()>& task) {
+    {
+        std::lock_guard<std::mutex> guard(m_state->mutex);
+
+        if(m_state->tasks.size() >= m_state->limit) {
+            return false;
+        }
+
+        m_state->tasks.emplace_back(key, task);
+    }
+
+    m_state->condition.notify_one();
+
+    return true;
+}
+
+size_t
+worker_pool_t::pending() const {
+    std::lock_guard<std::mutex> guard(m_state->mutex);
+
+    return m_state->tasks.size();
+}